@@ -0,0 +1,771 @@
+/**
+  ******************************************************************************
+  * @file	: bench_parser.cpp
+  * @brief	: Parity and Throughput of the Generic Parser against the Hand-Written One
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#include "bms_slave_ubt.hpp"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+
+using namespace Battery::Ubtbat;
+
+
+
+const uint32_t STREAM_FRAME_COUNT	= 4000;
+const uint32_t POLL_EXCHANGE_COUNT	= 2000;
+const uint32_t THROUGHPUT_PASSES	= 200;
+const uint8_t  THROUGHPUT_REPEATS	= 5;									//best of, the host is noisy
+const uint16_t THROUGHPUT_CHUNK		= 1024;
+const uint8_t  ANY_COMMAND		= 0;									//sniffer rule, every polled command
+
+
+
+/**
+  * @brief	Reference Parser, the hand-written Ubetter response parser and decoder as it was before the
+  *		protocol traits, with the signed current decode. ANY_COMMAND accepts every polled command like sniffer mode.
+  */
+class REFERENCE_PARSER
+{
+	public:
+		REFERENCE_PARSER():
+			parse_state(parse_state_type::START_BIT),
+			payload_index(0),
+			frame_count(0)
+		{ }
+
+		void responseRead(HAL_UART& port, uint8_t command_code)
+		{
+			uint8_t read_buffer[1024]	=	{0};
+			uint16_t read_buffer_size	=	port.readFromBuffer(read_buffer, sizeof(read_buffer));
+
+			for(uint16_t read_index = 0; read_index < read_buffer_size; read_index++)
+			{
+				parseByte(read_buffer[read_index], command_code);
+			}
+		}
+
+		void requestSent(void)
+		{
+			parse_state = parse_state_type::START_BIT;
+		}
+
+		const bms_data_type& getData(void) const	{ return bms_data; }
+		uint32_t getFrameCount(void) const		{ return frame_count; }
+
+	private:
+		void parseByte(uint8_t byte, uint8_t command_code)
+		{
+			uint16_t calculated_checksum = 0;
+
+			switch(parse_state)
+			{
+				case parse_state_type::START_BIT:
+					if(byte == 0XDD)
+					{
+						bms_response.data.start_bit = byte;
+						parse_state = parse_state_type::COMMAND_CODE;
+					}
+					break;
+
+				case parse_state_type::COMMAND_CODE:
+					if((byte == command_code) || ((command_code == ANY_COMMAND) && ((byte == 0x03) || (byte == 0x04) || (byte == 0x05))))
+					{
+						bms_response.data.command_code = byte;
+						parse_state = parse_state_type::STATUS_BIT;
+					}
+					else
+					{
+						parse_state = parse_state_type::START_BIT;
+					}
+					break;
+
+				case parse_state_type::STATUS_BIT:
+					bms_response.data.status_bit = byte;
+					parse_state = (byte == 0X00) ? parse_state_type::LENGTH : parse_state_type::START_BIT;
+					break;
+
+				case parse_state_type::LENGTH:
+					bms_response.data.data_length = byte;
+					payload_index = 0;
+					if(bms_response.data.data_length > sizeof(bms_response.data.payload))
+					{
+						parse_state = parse_state_type::START_BIT;
+					}
+					else
+					{
+						parse_state = (bms_response.data.data_length == 0) ? parse_state_type::CHECKSUM : parse_state_type::PAYLOAD;
+					}
+					break;
+
+				case parse_state_type::PAYLOAD:
+					bms_response.data.payload[payload_index++] = byte;
+					if(payload_index >= bms_response.data.data_length)
+					{
+						payload_index = 0;
+						parse_state = parse_state_type::CHECKSUM;
+					}
+					break;
+
+				case parse_state_type::CHECKSUM:
+					if(payload_index == 0)
+					{
+						bms_response.data.checksum = static_cast<uint16_t>( byte ) << 8;
+						payload_index++;
+						break;
+					}
+
+					bms_response.data.checksum |= static_cast<uint16_t>( byte );
+
+					for (uint8_t i = 0; i < bms_response.data.data_length; i++)
+					{
+						calculated_checksum += bms_response.data.payload[i];
+					}
+
+					calculated_checksum += bms_response.data.status_bit + bms_response.data.data_length;
+					calculated_checksum = (( ~calculated_checksum ) + 1);
+
+					parse_state = (calculated_checksum == bms_response.data.checksum) ? parse_state_type::STOP_BIT : parse_state_type::START_BIT;
+					break;
+
+				case parse_state_type::STOP_BIT:
+					if(byte == 0X77)
+					{
+						bms_response.data.stop_bit = byte;
+						processData();
+						frame_count++;
+					}
+					parse_state = parse_state_type::START_BIT;
+					break;
+
+				default:
+					parse_state = parse_state_type::START_BIT;
+					break;
+			}
+		}
+
+		void processData(void)
+		{
+			uint8_t length = bms_response.data.data_length;
+
+			switch(bms_response.data.command_code)
+			{
+				case 0x03:
+					memcpy(&info_type.buffer[0], &bms_response.data.payload, (length < sizeof(info_type.buffer)) ? length : sizeof(info_type.buffer));
+
+					raw_type.data.total_voltage		= static_cast<uint16_t>(info_type.data.total_voltage_lo) 		| (static_cast<uint16_t>(info_type.data.total_voltage_hi) 		<< 8);
+					raw_type.data.current			= static_cast<uint16_t>(info_type.data.current_lo) 			| (static_cast<uint16_t>(info_type.data.current_hi) 			<< 8);
+					raw_type.data.residual_capacity		= static_cast<uint16_t>(info_type.data.residual_capacity_lo)		| (static_cast<uint16_t>(info_type.data.residual_capacity_hi) 	<< 8);
+					raw_type.data.nominal_capacity		= static_cast<uint16_t>(info_type.data.nominal_capacity_lo) 		| (static_cast<uint16_t>(info_type.data.nominal_capacity_hi) 	<< 8);
+					raw_type.data.number_of_cycles		= static_cast<uint16_t>(info_type.data.number_of_cycles_lo) 		| (static_cast<uint16_t>(info_type.data.number_of_cycles_hi) 	<< 8);
+					raw_type.data.production_date		= static_cast<uint16_t>(info_type.data.production_date_lo)		| (static_cast<uint16_t>(info_type.data.production_date_hi) 	<< 8);
+					raw_type.data.balance_status_low	= static_cast<uint16_t>(info_type.data.balance_status_low_lo) 		| (static_cast<uint16_t>(info_type.data.balance_status_low_hi) 	<< 8);
+					raw_type.data.balance_status_high	= static_cast<uint16_t>(info_type.data.balance_status_high_lo) 		| (static_cast<uint16_t>(info_type.data.balance_status_high_hi) << 8);
+					raw_type.data.protection_status		= static_cast<uint16_t>(info_type.data.protection_status_lo) 		| (static_cast<uint16_t>(info_type.data.protection_status_hi) 	<< 8);
+					raw_type.data.software_version		= info_type.data.software_version;
+					raw_type.data.remaining_capacity	= info_type.data.remaining_capacity;
+					raw_type.data.fet_control_status	= info_type.data.fet_control_status;
+					raw_type.data.number_of_battery		= info_type.data.number_of_battery;
+					raw_type.data.number_of_ntc		= info_type.data.number_of_ntc;
+					raw_type.data.cell_temp_1st		= static_cast<uint16_t>(info_type.data.cell_temp_1st_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_1st_hi) 		<< 8);
+					raw_type.data.cell_temp_2nd		= static_cast<uint16_t>(info_type.data.cell_temp_2nd_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_2nd_hi) 		<< 8);
+					raw_type.data.cell_temp_3rd		= static_cast<uint16_t>(info_type.data.cell_temp_3rd_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_3rd_hi) 		<< 8);
+					raw_type.data.cell_temp_4th		= static_cast<uint16_t>(info_type.data.cell_temp_4th_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_4th_hi) 		<< 8);
+
+					bms_data.data.total_voltage_v 			= static_cast<float>(raw_type.data.total_voltage) * 0.01;
+					bms_data.data.current_a 			= static_cast<float>(static_cast<int16_t>(raw_type.data.current)) * 0.01;
+					bms_data.data.residual_capacity_mah 		= raw_type.data.residual_capacity * 10;
+					bms_data.data.nominal_capacity_mah		= raw_type.data.nominal_capacity * 10;
+					bms_data.data.number_of_cycles			= raw_type.data.number_of_cycles;
+					bms_data.data.production_date.data.years	= ((raw_type.data.production_date >> 9) + 2000);
+					bms_data.data.production_date.data.months	= ((raw_type.data.production_date >> 5) & 0x0F);
+					bms_data.data.production_date.data.days		= (raw_type.data.production_date & 0x1F);
+
+					bms_data.data.balance_status_low		= raw_type.data.balance_status_low;
+					bms_data.data.balance_status_high		= raw_type.data.balance_status_high;
+					bms_data.data.protection_status.u16		= raw_type.data.protection_status;
+					bms_data.data.software_version.data.major	= (raw_type.data.software_version / 10);
+					bms_data.data.software_version.data.minor	= (raw_type.data.software_version % 10);
+					bms_data.data.remaining_capacity_per		= raw_type.data.remaining_capacity;
+					bms_data.data.fet_control_status.u8		= raw_type.data.fet_control_status;
+
+					bms_data.data.number_of_battery_strings		= raw_type.data.number_of_battery;
+					bms_data.data.number_of_ntc			= raw_type.data.number_of_ntc;
+					bms_data.data.cell_temp_1st			= ((static_cast<float>(raw_type.data.cell_temp_1st) - 2731) / 10);
+					bms_data.data.cell_temp_2nd			= ((static_cast<float>(raw_type.data.cell_temp_2nd) - 2731) / 10);
+					bms_data.data.cell_temp_3rd			= ((static_cast<float>(raw_type.data.cell_temp_3rd) - 2731) / 10);
+					bms_data.data.cell_temp_4th			= ((static_cast<float>(raw_type.data.cell_temp_4th) - 2731) / 10);
+					break;
+
+				case 0x04:
+					length = (length < sizeof(cell_type.buffer)) ? length : sizeof(cell_type.buffer);
+					memcpy(&cell_type.data.cell_voltage_mv[0], &bms_response.data.payload, length);
+
+					for(uint8_t cell_index = 0; (cell_index < length / 2); cell_index++)
+					{
+						cell_type.data.cell_voltage_mv[cell_index] = ((cell_type.data.cell_voltage_mv[cell_index] & 0xFF) << 8) | (cell_type.data.cell_voltage_mv[cell_index] >> 8);
+					}
+
+					memcpy(&bms_data.data.cell_voltage_mv[0], &cell_type.data.cell_voltage_mv[0], (length / 2) * 2);
+					break;
+
+				case 0x05:
+					length = (length < sizeof(version_type.buffer)) ? length : sizeof(version_type.buffer);
+					memcpy(&version_type.data.version_number[0], &bms_response.data.payload, length);
+
+					memcpy(&bms_data.data.version_number[0], &version_type.data.version_number[0], length);
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		parse_state_type parse_state;
+		bms_ubetter_response_type bms_response;
+		uint8_t payload_index;
+		uint32_t frame_count;
+
+		commnd_info_data_type info_type;
+		raw_data_info_type raw_type;
+		commnd_cell_data_type cell_type;
+		commnd_version_data_type version_type;
+		bms_data_type bms_data;
+};
+
+
+
+/**
+  * @brief 	Deterministic pseudo random source, xorshift32
+  */
+static uint32_t randomNext(void)
+{
+	static uint32_t state = 0x2545F491;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+
+
+
+/**
+  * @brief 	Append one response frame
+  * @param[in]  uint8_t command_code, uint8_t status_bit
+  * @param[in]  const uint8_t payload[], uint8_t length
+  * @param[in]  bool corrupt	: wrong checksum if true
+  * @param[out] std::vector<uint8_t>& stream
+  * @return 	void
+  */
+static void appendFrame(std::vector<uint8_t>& stream, uint8_t command_code, uint8_t status_bit, const uint8_t payload[], uint8_t length, bool corrupt)
+{
+	uint16_t checksum = status_bit + length;
+
+	stream.push_back(0XDD);
+	stream.push_back(command_code);
+	stream.push_back(status_bit);
+	stream.push_back(length);
+
+	for(uint8_t index = 0; index < length; index++)
+	{
+		stream.push_back(payload[index]);
+		checksum += payload[index];
+	}
+
+	checksum = static_cast<uint16_t>(( ~checksum ) + 1) ^ (corrupt ? 0x0100 : 0);
+	stream.push_back(static_cast<uint8_t>(checksum >> 8));
+	stream.push_back(static_cast<uint8_t>(checksum & 0xFF));
+	stream.push_back(0X77);
+}
+
+
+
+/**
+  * @brief 	Append one response frame with random payload
+  * @param[in]  uint8_t command_code, uint8_t status_bit, uint8_t length, bool corrupt	: wrong checksum if true
+  * @param[out] std::vector<uint8_t>& stream
+  * @return 	void
+  */
+static void appendFrame(std::vector<uint8_t>& stream, uint8_t command_code, uint8_t status_bit, uint8_t length, bool corrupt)
+{
+	uint8_t payload[256] = {0};
+
+	for(uint16_t index = 0; index < length; index++)
+	{
+		payload[index] = static_cast<uint8_t>(randomNext());
+	}
+
+	appendFrame(stream, command_code, status_bit, payload, length, corrupt);
+}
+
+
+
+/**
+  * @brief 	Append a good answer to one command, lengths as the pack sends them
+  * @param[in]  uint8_t command_code
+  * @param[out] std::vector<uint8_t>& stream
+  * @return 	void
+  */
+static void appendAnswer(std::vector<uint8_t>& stream, uint8_t command_code)
+{
+	switch(command_code)
+	{
+		case 0x03:
+			appendFrame(stream, 0x03, 0X00, 31, false);
+			break;
+
+		case 0x04:
+			appendFrame(stream, 0x04, 0X00, static_cast<uint8_t>(2 * (1 + (randomNext() % 17))), false);
+			break;
+
+		default:
+			appendFrame(stream, command_code, 0X00, static_cast<uint8_t>(1 + (randomNext() % 10)), false);
+			break;
+	}
+}
+
+
+
+/**
+  * @brief 	Build the test stream: good frames of every command, error status, bad checksum,
+  *		unknown commands, truncated frames and line noise
+  * @param[out] std::vector<uint8_t>& stream
+  * @return 	void
+  */
+static void buildStream(std::vector<uint8_t>& stream)
+{
+	for(uint32_t frame = 0; frame < STREAM_FRAME_COUNT; frame++)
+	{
+		uint32_t kind = randomNext() % 16;
+		size_t frame_start = stream.size();
+
+		if(kind < 5)
+		{
+			appendAnswer(stream, 0x03);
+		}
+		else if(kind < 9)
+		{
+			appendAnswer(stream, 0x04);
+		}
+		else if(kind < 10)
+		{
+			appendAnswer(stream, 0x05);
+		}
+		else if(kind < 11)
+		{
+			appendFrame(stream, static_cast<uint8_t>(0x03 + (randomNext() % 3)), 0X80, 0, false);
+		}
+		else if(kind < 12)
+		{
+			appendFrame(stream, 0x03, 0X00, 31, true);
+		}
+		else if(kind < 13)
+		{
+			appendFrame(stream, 0XE1, 0X00, 2, false);
+		}
+		else if(kind < 14)
+		{
+			appendFrame(stream, 0x04, 0X00, 32, false);
+			stream.resize(frame_start + 4 + (randomNext() % 30));
+		}
+		else
+		{
+			for(uint32_t noise = randomNext() % 8; noise > 0; noise--)
+			{
+				uint8_t byte = static_cast<uint8_t>(randomNext());
+				stream.push_back((byte == 0XDD) ? 0x00 : byte);
+			}
+		}
+	}
+}
+
+
+
+/**
+  * @brief 	Build the byte loop stream: well formed frames of every command with a wrong checksum,
+  *		both parsers walk every byte up to the checksum and never decode
+  * @param[out] std::vector<uint8_t>& stream
+  * @return 	void
+  */
+static void buildChecksumStream(std::vector<uint8_t>& stream)
+{
+	for(uint32_t frame = 0; frame < STREAM_FRAME_COUNT; frame++)
+	{
+		appendFrame(stream, static_cast<uint8_t>(0x03 + (frame % 3)), 0X00, (frame % 3) == 0 ? 31 : 32, true);
+	}
+}
+
+
+
+/**
+  * @brief 	Sniffer Parity, both parsers get the same chunks, snapshots must be byte equal after each chunk
+  * @param[in]  const std::vector<uint8_t>& stream
+  * @return 	bool
+  */
+static bool snifferParity(const std::vector<uint8_t>& stream)
+{
+	static HAL_UART slave_port;
+	static BMS_SLAVE_UBT slave(slave_port);
+	static REFERENCE_PARSER reference;
+	HAL_UART reference_port;
+	size_t offset = 0;
+	uint32_t chunks = 0;
+
+	slave.setSnifferMode(true);
+
+	while(offset < stream.size())
+	{
+		uint16_t chunk = static_cast<uint16_t>(1 + (randomNext() % 64));
+		if(chunk > (stream.size() - offset))
+		{
+			chunk = static_cast<uint16_t>(stream.size() - offset);
+		}
+
+		slave_port.inject(&stream[offset], chunk);
+		reference_port.inject(&stream[offset], chunk);
+		slave.scheduler();
+		reference.responseRead(reference_port, ANY_COMMAND);
+		offset += chunk;
+		chunks++;
+
+		if(memcmp(slave.getData().buffer, reference.getData().buffer, sizeof(bms_data_type)) != 0)
+		{
+			printf("sniffer : MISMATCH after byte %zu (chunk %u)\n", offset, chunks);
+			return false;
+		}
+	}
+
+	printf("sniffer : %zu bytes, %u chunks, %u frames decoded, snapshots identical\n", stream.size(), chunks, reference.getFrameCount());
+	return true;
+}
+
+
+
+/**
+  * @brief 	Poll Request, runs the driver until it sends a request
+  * @param[in]  SLAVE& slave, HAL_UART& port
+  * @param[out] uint8_t& command_code	: requested command
+  * @return 	bool false if no request within 500 ms
+  */
+template <typename SLAVE>
+static bool pollRequest(SLAVE& slave, HAL_UART& port, uint8_t& command_code)
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+	uint8_t request[16] = {0};
+
+	while(std::chrono::steady_clock::now() < deadline)
+	{
+		slave.scheduler();
+		if(port.takeRequest(request, sizeof(request)) >= sizeof(bms_ubetter_request_type))
+		{
+			command_code = request[2];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+/**
+  * @brief 	Poll Parity, the driver polls, every answer may carry noise and an unsolicited frame of another
+  *		command in front and is split over two reads. The reference expects the requested command only.
+  * @param[in]  void
+  * @return 	bool
+  */
+static bool pollParity(void)
+{
+	static HAL_UART slave_port;
+	static BMS_SLAVE_UBT slave(slave_port);
+	static REFERENCE_PARSER reference;
+	HAL_UART reference_port;
+	std::vector<uint8_t> answer;
+	uint8_t command_code = 0;
+	uint8_t kind = 0;
+	size_t split = 0;
+
+	slave.initialize();
+	slave.setCommandPeriod(0x03, 1);
+	slave.setCommandPeriod(0x04, 1);
+
+	for(uint32_t exchange = 0; exchange < POLL_EXCHANGE_COUNT; exchange++)
+	{
+		if(pollRequest(slave, slave_port, command_code) == false)
+		{
+			printf("polled  : no request at exchange %u\n", exchange);
+			return false;
+		}
+		reference.requestSent();
+
+		answer.clear();
+		if((randomNext() % 4) == 0)
+		{
+			answer.push_back(static_cast<uint8_t>(randomNext() & 0x7F));					//noise, never a start bit
+			appendAnswer(answer, static_cast<uint8_t>(0x03 + ((command_code - 0x03 + 1 + (randomNext() % 2)) % 3)));
+		}
+
+		kind = (exchange == 0) ? 0 : static_cast<uint8_t>(randomNext() % 10);					//probe must succeed
+		if(kind == 8)
+		{
+			appendFrame(answer, command_code, 0X80, 0, false);
+		}
+		else if(kind == 9)
+		{
+			appendFrame(answer, command_code, 0X00, (command_code == 0x03) ? 31 : 8, true);
+		}
+		else
+		{
+			appendAnswer(answer, command_code);
+		}
+
+		split = randomNext() % answer.size();
+		slave_port.inject(&answer[0], static_cast<uint16_t>(split));
+		reference_port.inject(&answer[0], static_cast<uint16_t>(split));
+		slave.scheduler();
+		reference.responseRead(reference_port, command_code);
+		slave_port.inject(&answer[split], static_cast<uint16_t>(answer.size() - split));
+		reference_port.inject(&answer[split], static_cast<uint16_t>(answer.size() - split));
+		slave.scheduler();
+		reference.responseRead(reference_port, command_code);
+
+		if(memcmp(slave.getData().buffer, reference.getData().buffer, sizeof(bms_data_type)) != 0)
+		{
+			printf("polled  : MISMATCH at exchange %u, command 0x%02X\n", exchange, command_code);
+			return false;
+		}
+	}
+
+	printf("polled  : %u exchanges, %u frames decoded, snapshots identical\n", POLL_EXCHANGE_COUNT, reference.getFrameCount());
+	return true;
+}
+
+
+
+/**
+  * @brief 	JBD Info Case, one info payload and the values it must decode to
+  */
+struct jbd_info_case_type
+{
+	uint8_t  length;
+	uint8_t  payload[40];
+	float    total_voltage_v;
+	float    current_a;
+	uint16_t number_of_ntc;
+	float    cell_temp[4];
+};
+
+
+
+/**
+  * @brief 	JBD Info Cases: 2 NTCs with 3 trailing bytes, 1 NTC with 5 trailing bytes, a frame shorter than
+  *		the fixed part which must leave the snapshot alone, 4 NTCs without trailing bytes
+  */
+static const jbd_info_case_type JBD_INFO_CASES[] =
+{
+	{ 30, { 0x14, 0x6C, 0xFF, 0x9C, 0x03, 0xE8, 0x03, 0xE8, 0x00, 0x05, 0x2A, 0x21, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x12, 0x50, 0x03, 0x10, 0x02,
+		0x0B, 0xA5, 0x0B, 0xAF, 0x00, 0x00, 0x01 },
+	  52.28f, -1.00f, 2, { 25.0f, 26.0f, 0.0f, 0.0f } },
+	{ 30, { 0x14, 0x50, 0x00, 0x64, 0x03, 0xE8, 0x03, 0xE8, 0x00, 0x05, 0x2A, 0x21, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x12, 0x50, 0x03, 0x10, 0x01,
+		0x0B, 0xB9, 0x01, 0x02, 0x03, 0x04, 0x05 },
+	  52.00f, 1.00f, 1, { 27.0f, 0.0f, 0.0f, 0.0f } },
+	{ 20, { 0x13, 0x88, 0x00, 0x00, 0x03, 0xE8, 0x03, 0xE8, 0x00, 0x05, 0x2A, 0x21, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x12, 0x50 },
+	  52.00f, 1.00f, 1, { 27.0f, 0.0f, 0.0f, 0.0f } },
+	{ 31, { 0x13, 0x88, 0x01, 0xF4, 0x03, 0xE8, 0x03, 0xE8, 0x00, 0x05, 0x2A, 0x21, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x12, 0x50, 0x03, 0x10, 0x04,
+		0x0B, 0xA5, 0x0B, 0xAF, 0x0B, 0xB9, 0x0B, 0xC3 },
+	  50.00f, 5.00f, 4, { 25.0f, 26.0f, 27.0f, 28.0f } },
+};
+
+
+
+/**
+  * @brief 	Near, decoded float against the expected value
+  */
+static bool near(float value, float expected)
+{
+	return (value > (expected - 0.005f)) && (value < (expected + 0.005f));
+}
+
+
+
+/**
+  * @brief 	JBD Check, a polled JBD driver gets the info cases in turn and must decode the expected values
+  * @param[in]  void
+  * @return 	bool
+  */
+static bool jbdCheck(void)
+{
+	static HAL_UART slave_port;
+	static BMS_SLAVE_JBD slave(slave_port);
+	std::vector<uint8_t> answer;
+	uint8_t command_code = 0;
+	uint8_t case_index = 0;
+	uint32_t exchange = 0;
+	bms_data_type data;
+
+	slave.initialize();
+	slave.setCommandPeriod(0x03, 1);
+
+	for(exchange = 0; (exchange < 100) && (case_index < (sizeof(JBD_INFO_CASES) / sizeof(JBD_INFO_CASES[0]))); exchange++)
+	{
+		const jbd_info_case_type& info = JBD_INFO_CASES[case_index];
+
+		if(pollRequest(slave, slave_port, command_code) == false)
+		{
+			printf("jbd     : no request at exchange %u\n", exchange);
+			return false;
+		}
+
+		answer.clear();
+		if(command_code == 0x03)
+		{
+			appendFrame(answer, 0x03, 0X00, info.payload, info.length, false);
+		}
+		else
+		{
+			appendAnswer(answer, command_code);
+		}
+		slave_port.inject(&answer[0], static_cast<uint16_t>(answer.size()));
+		slave.scheduler();
+
+		if(command_code != 0x03)
+		{
+			continue;
+		}
+
+		data = slave.getData();
+		if((near(data.data.total_voltage_v, info.total_voltage_v) == false) || (near(data.data.current_a, info.current_a) == false) ||
+		   (data.data.number_of_ntc != info.number_of_ntc) || (data.data.number_of_battery_strings != 16) ||
+		   (data.data.residual_capacity_mah != 10000) || (data.data.production_date.data.years != 2021) ||
+		   (near(data.data.cell_temp_1st, info.cell_temp[0]) == false) || (near(data.data.cell_temp_2nd, info.cell_temp[1]) == false) ||
+		   (near(data.data.cell_temp_3rd, info.cell_temp[2]) == false) || (near(data.data.cell_temp_4th, info.cell_temp[3]) == false))
+		{
+			printf("jbd     : MISMATCH in info case %u\n", case_index);
+			return false;
+		}
+		case_index++;
+	}
+
+	if(case_index < (sizeof(JBD_INFO_CASES) / sizeof(JBD_INFO_CASES[0])))
+	{
+		printf("jbd     : only %u info cases answered\n", case_index);
+		return false;
+	}
+
+	printf("jbd     : %u info cases (1, 2, 4 NTCs, trailing bytes, short frame) decoded as expected\n", case_index);
+	return true;
+}
+
+
+
+/**
+  * @brief 	Time Generic, best of THROUGHPUT_REPEATS, ns per byte through the sniffing driver
+  * @param[in]  const std::vector<uint8_t>& stream
+  * @return 	double
+  */
+static double timeGeneric(const std::vector<uint8_t>& stream)
+{
+	static HAL_UART slave_port;
+	static BMS_SLAVE_UBT slave(slave_port);
+	std::chrono::steady_clock::time_point start;
+	double best_ns = 0;
+	double elapsed_ns = 0;
+
+	slave.setSnifferMode(true);
+
+	for(uint8_t repeat = 0; repeat < THROUGHPUT_REPEATS; repeat++)
+	{
+		start = std::chrono::steady_clock::now();
+		for(uint32_t pass = 0; pass < THROUGHPUT_PASSES; pass++)
+		{
+			for(size_t offset = 0; offset < stream.size(); offset += THROUGHPUT_CHUNK)
+			{
+				slave_port.inject(&stream[offset], static_cast<uint16_t>(((stream.size() - offset) < THROUGHPUT_CHUNK) ? (stream.size() - offset) : THROUGHPUT_CHUNK));
+				slave.scheduler();
+			}
+		}
+		elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		best_ns = ((repeat == 0) || (elapsed_ns < best_ns)) ? elapsed_ns : best_ns;
+	}
+
+	return best_ns / (static_cast<double>(stream.size()) * THROUGHPUT_PASSES);
+}
+
+
+
+/**
+  * @brief 	Time Reference, best of THROUGHPUT_REPEATS, ns per byte through the hand-written parser
+  * @param[in]  const std::vector<uint8_t>& stream
+  * @return 	double
+  */
+static double timeReference(const std::vector<uint8_t>& stream)
+{
+	static REFERENCE_PARSER reference;
+	HAL_UART reference_port;
+	std::chrono::steady_clock::time_point start;
+	double best_ns = 0;
+	double elapsed_ns = 0;
+
+	for(uint8_t repeat = 0; repeat < THROUGHPUT_REPEATS; repeat++)
+	{
+		start = std::chrono::steady_clock::now();
+		for(uint32_t pass = 0; pass < THROUGHPUT_PASSES; pass++)
+		{
+			for(size_t offset = 0; offset < stream.size(); offset += THROUGHPUT_CHUNK)
+			{
+				reference_port.inject(&stream[offset], static_cast<uint16_t>(((stream.size() - offset) < THROUGHPUT_CHUNK) ? (stream.size() - offset) : THROUGHPUT_CHUNK));
+				reference.responseRead(reference_port, ANY_COMMAND);
+			}
+		}
+		elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		best_ns = ((repeat == 0) || (elapsed_ns < best_ns)) ? elapsed_ns : best_ns;
+	}
+
+	return best_ns / (static_cast<double>(stream.size()) * THROUGHPUT_PASSES);
+}
+
+
+
+int main(void)
+{
+	std::vector<uint8_t> stream;
+	std::vector<uint8_t> checksum_stream;
+
+	buildStream(stream);
+	buildChecksumStream(checksum_stream);
+
+	if((snifferParity(stream) == false) || (pollParity() == false) || (jbdCheck() == false))
+	{
+		return 1;
+	}
+
+	printf("byte loop, no decode : generic %.2f ns/byte, hand %.2f ns/byte\n", timeGeneric(checksum_stream), timeReference(checksum_stream));
+	printf("full driver          : generic %.2f ns/byte, hand %.2f ns/byte (generic adds stamps, adaptive, balance, link health)\n",
+	       timeGeneric(stream), timeReference(stream));
+
+	return 0;
+}
+
+/********************************* END OF FILE *********************************/
@@ -0,0 +1,266 @@
+/**
+  ******************************************************************************
+  * @file	: bench_rack.cpp
+  * @brief	: Rack Aggregation of 256 Packs, Segment Tree against Full Rescan
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#include "bms_rack_ubt.hpp"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+
+using namespace Battery::Ubtbat;
+
+
+
+const uint16_t RACK_PACK_COUNT		= BMS_RACK_MAX_PACKS;
+const uint8_t  RACK_CELL_COUNT		= 16;
+const uint8_t  RACK_NTC_COUNT		= 4;
+const uint32_t CHECK_FRAME_COUNT	= 50000;
+const uint32_t TIMED_FRAME_COUNT	= 200000;
+
+
+
+static bms_data_type packs[RACK_PACK_COUNT];
+static bool pack_present[RACK_PACK_COUNT];
+static volatile uint32_t sink;
+
+
+
+/**
+  * @brief 	Deterministic pseudo random source, xorshift32
+  */
+static uint32_t randomNext(void)
+{
+	static uint32_t state = 0x9E3779B9;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+
+
+
+/**
+  * @brief 	Random frame content, current and voltage in 0.25 steps so float sums are exact in any order
+  * @param[out] bms_data_type& data
+  * @return 	void
+  */
+static void randomPack(bms_data_type& data)
+{
+	float* cell_temp[RACK_NTC_COUNT] = { &data.data.cell_temp_1st, &data.data.cell_temp_2nd, &data.data.cell_temp_3rd, &data.data.cell_temp_4th };
+
+	data.data.number_of_battery_strings	= RACK_CELL_COUNT;
+	data.data.number_of_ntc			= RACK_NTC_COUNT;
+	data.data.current_a			= static_cast<float>(static_cast<int32_t>(randomNext() % 801) - 400) * 0.25f;
+	data.data.total_voltage_v		= 48.0f + static_cast<float>(randomNext() % 33) * 0.25f;
+
+	for(uint8_t cell_index = 0; cell_index < RACK_CELL_COUNT; cell_index++)
+	{
+		data.data.cell_voltage_mv[cell_index] = static_cast<uint16_t>(3100 + (randomNext() % 300));
+	}
+	for(uint8_t ntc_index = 0; ntc_index < RACK_NTC_COUNT; ntc_index++)
+	{
+		*cell_temp[ntc_index] = static_cast<float>(randomNext() % 600) / 10;
+	}
+}
+
+
+
+/**
+  * @brief 	Rescan Baseline, walks every cell of every pack, ties keep the lower pack like the tree
+  * @param[out] bms_rack_summary_type& summary
+  * @return 	void
+  */
+static void rescan(bms_rack_summary_type& summary)
+{
+	memset(&summary, 0, sizeof(summary));
+	summary.min_cell_mv	= UINT16_MAX;
+	summary.min_cell_pack	= BMS_RACK_NO_PACK;
+	summary.max_cell_pack	= BMS_RACK_NO_PACK;
+	summary.max_temp	= -1000.0;
+	summary.max_temp_pack	= BMS_RACK_NO_PACK;
+
+	for(uint16_t pack_index = 0; pack_index < RACK_PACK_COUNT; pack_index++)
+	{
+		const bms_data_type& data = packs[pack_index];
+		const float* cell_temp[RACK_NTC_COUNT] = { &data.data.cell_temp_1st, &data.data.cell_temp_2nd, &data.data.cell_temp_3rd, &data.data.cell_temp_4th };
+
+		if(pack_present[pack_index] == false)
+		{
+			continue;
+		}
+
+		for(uint8_t cell_index = 0; cell_index < data.data.number_of_battery_strings; cell_index++)
+		{
+			uint16_t cell_mv = data.data.cell_voltage_mv[cell_index];
+
+			if(cell_mv < summary.min_cell_mv)
+			{
+				summary.min_cell_mv	= cell_mv;
+				summary.min_cell_pack	= pack_index;
+				summary.min_cell_index	= cell_index;
+			}
+			if((summary.max_cell_pack == BMS_RACK_NO_PACK) || (cell_mv > summary.max_cell_mv))
+			{
+				summary.max_cell_mv	= cell_mv;
+				summary.max_cell_pack	= pack_index;
+				summary.max_cell_index	= cell_index;
+			}
+		}
+
+		for(uint8_t ntc_index = 0; ntc_index < data.data.number_of_ntc; ntc_index++)
+		{
+			if(*cell_temp[ntc_index] > summary.max_temp)
+			{
+				summary.max_temp	= *cell_temp[ntc_index];
+				summary.max_temp_pack	= pack_index;
+				summary.max_temp_index	= ntc_index;
+			}
+		}
+
+		summary.sum_current_a	+= data.data.current_a;
+		summary.sum_voltage_v	+= data.data.total_voltage_v;
+		summary.pack_count++;
+	}
+}
+
+
+
+/**
+  * @brief 	Summary Compare, field by field
+  * @param[in]  const bms_rack_summary_type& tree, rescan
+  * @return 	bool true if equal
+  */
+static bool summaryEqual(const bms_rack_summary_type& tree, const bms_rack_summary_type& scan)
+{
+	return (tree.min_cell_mv == scan.min_cell_mv) && (tree.min_cell_pack == scan.min_cell_pack) && (tree.min_cell_index == scan.min_cell_index) &&
+	       (tree.max_cell_mv == scan.max_cell_mv) && (tree.max_cell_pack == scan.max_cell_pack) && (tree.max_cell_index == scan.max_cell_index) &&
+	       (tree.max_temp == scan.max_temp) && (tree.max_temp_pack == scan.max_temp_pack) && (tree.max_temp_index == scan.max_temp_index) &&
+	       (tree.sum_current_a == scan.sum_current_a) && (tree.sum_voltage_v == scan.sum_voltage_v) && (tree.pack_count == scan.pack_count);
+}
+
+
+
+/**
+  * @brief 	Equality, every frame refreshes or drops one pack, the tree summary must equal the rescan
+  * @param[in]  BMS_RACK_UBT& rack
+  * @return 	bool
+  */
+static bool equalityCheck(BMS_RACK_UBT& rack)
+{
+	bms_rack_summary_type scan;
+	uint32_t removed = 0;
+
+	for(uint32_t frame = 0; frame < CHECK_FRAME_COUNT; frame++)
+	{
+		uint16_t pack_index = static_cast<uint16_t>(randomNext() % RACK_PACK_COUNT);
+
+		if((randomNext() % 64) == 0)
+		{
+			rack.remove(pack_index);										//pack lost
+			pack_present[pack_index] = false;
+			removed++;
+		}
+		else
+		{
+			randomPack(packs[pack_index]);
+			rack.update(pack_index, packs[pack_index], rack_frame_type::CELL, frame);
+			pack_present[pack_index] = true;
+		}
+
+		rescan(scan);
+		if(summaryEqual(rack.getSummary(), scan) == false)
+		{
+			printf("equality: MISMATCH at frame %u, pack %u\n", frame, pack_index);
+			return false;
+		}
+	}
+
+	printf("equality: %u frames, %u removals, tree summary equals rescan after every frame\n", CHECK_FRAME_COUNT, removed);
+	return true;
+}
+
+
+
+/**
+  * @brief 	Throughput, one cell change per frame followed by a summary read
+  * @param[in]  BMS_RACK_UBT& rack
+  * @return 	void
+  */
+static void throughput(BMS_RACK_UBT& rack)
+{
+	std::chrono::steady_clock::time_point start;
+	bms_rack_summary_type scan;
+	double tree_ns = 0;
+	double scan_ns = 0;
+
+	for(uint16_t pack_index = 0; pack_index < RACK_PACK_COUNT; pack_index++)
+	{
+		rack.update(pack_index, packs[pack_index], rack_frame_type::CELL, 0);
+		pack_present[pack_index] = true;
+	}
+
+	start = std::chrono::steady_clock::now();
+	for(uint32_t frame = 0; frame < TIMED_FRAME_COUNT; frame++)
+	{
+		uint16_t pack_index = static_cast<uint16_t>((frame * 97) % RACK_PACK_COUNT);
+
+		packs[pack_index].data.cell_voltage_mv[frame % RACK_CELL_COUNT] ^= 1;
+		rack.update(pack_index, packs[pack_index], rack_frame_type::CELL, frame);
+		sink = rack.getSummary().min_cell_mv;
+	}
+	tree_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for(uint32_t frame = 0; frame < TIMED_FRAME_COUNT; frame++)
+	{
+		uint16_t pack_index = static_cast<uint16_t>((frame * 97) % RACK_PACK_COUNT);
+
+		packs[pack_index].data.cell_voltage_mv[frame % RACK_CELL_COUNT] ^= 1;
+		rescan(scan);
+		sink = scan.min_cell_mv;
+	}
+	scan_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	printf("tree    : %.0f ns/frame\n", tree_ns / TIMED_FRAME_COUNT);
+	printf("rescan  : %.0f ns/frame\n", scan_ns / TIMED_FRAME_COUNT);
+}
+
+
+
+int main(void)
+{
+	static BMS_RACK_UBT rack;
+
+	if(equalityCheck(rack) == false)
+	{
+		return 1;
+	}
+
+	throughput(rack);
+
+	return 0;
+}
+
+/********************************* END OF FILE *********************************/
@@ -0,0 +1,343 @@
+/**
+  ******************************************************************************
+  * @file	: bench_startup.cpp
+  * @brief	: Startup Time of Emulated Packs on Separate Ports, Cold and Warm Start
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#include "bms_slave_ubt.hpp"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+
+using namespace Battery::Ubtbat;
+
+
+
+const uint8_t  LIVE_PACK_COUNT		= 8;
+const uint8_t  DEAD_PACK_COUNT		= 2;								//ports without a pack, never answer
+const uint8_t  PORT_COUNT		= LIVE_PACK_COUNT + DEAD_PACK_COUNT;
+const uint32_t PACK_LATENCY_US		= 40000;
+const uint32_t LOOP_PERIOD_US		= 500;
+const uint32_t STARTUP_DEADLINE_MS	= 5000;
+
+
+
+/**
+  * @brief 	Emulated Pack, static content of one pack behind a port
+  */
+struct emulated_pack_type
+{
+	uint8_t pack_index;
+	uint8_t cell_count;
+};
+
+
+
+/**
+  * @brief 	Startup Result Type
+  */
+struct startup_result_type
+{
+	bool     complete;
+	double   elapsed_ms;
+	uint32_t live_requests;
+	uint32_t dead_requests;
+	uint8_t  warm_count;
+};
+
+
+
+static HAL_UART ports[PORT_COUNT];
+static emulated_pack_type emulated_packs[PORT_COUNT];
+
+
+
+/**
+  * @brief 	Build one response frame
+  * @param[in]  uint8_t command_code, const uint8_t payload[], uint8_t length
+  * @param[out] uint8_t response[]
+  * @return 	uint16_t frame size
+  */
+static uint16_t buildFrame(uint8_t response[], uint8_t command_code, const uint8_t payload[], uint8_t length)
+{
+	uint16_t checksum = length;
+
+	response[0] = 0XDD;
+	response[1] = command_code;
+	response[2] = 0X00;
+	response[3] = length;
+
+	for(uint8_t index = 0; index < length; index++)
+	{
+		response[4 + index] = payload[index];
+		checksum += payload[index];
+	}
+
+	checksum = static_cast<uint16_t>(( ~checksum ) + 1);
+	response[4 + length] = static_cast<uint8_t>(checksum >> 8);
+	response[5 + length] = static_cast<uint8_t>(checksum & 0xFF);
+	response[6 + length] = 0X77;
+
+	return static_cast<uint16_t>(7 + length);
+}
+
+
+
+/**
+  * @brief 	Pack Emulator, answers info, cell and version reads of one pack
+  * @param[in]  void* context	: emulated_pack_type
+  * @param[in]  const uint8_t* request, uint16_t request_size
+  * @param[out] uint8_t* response
+  * @param[in]  uint16_t response_size
+  * @return 	uint16_t response size
+  */
+static uint16_t packEmulator(void* context, const uint8_t* request, uint16_t request_size, uint8_t* response, uint16_t response_size)
+{
+	const emulated_pack_type* pack = static_cast<const emulated_pack_type*>(context);
+	uint8_t payload[40] = {0};
+	uint16_t total_voltage = static_cast<uint16_t>(pack->cell_count * 330);
+	uint8_t length = 0;
+
+	if((request_size < 7) || (request[1] != 0XA5) || (response_size < 64))
+	{
+		return 0;
+	}
+
+	switch(request[2])
+	{
+		case 0x03:
+			payload[0]	= static_cast<uint8_t>(total_voltage >> 8);
+			payload[1]	= static_cast<uint8_t>(total_voltage & 0xFF);
+			payload[6]	= 0x27;									//nominal capacity 100 Ah
+			payload[7]	= 0x10;
+			payload[18]	= 0x12;									//software version 1.8
+			payload[19]	= 80;										//remaining capacity %
+			payload[21]	= pack->cell_count;
+			payload[22]	= 4;
+			for(uint8_t ntc_index = 0; ntc_index < 4; ntc_index++)
+			{
+				payload[23 + (ntc_index * 2)] = 0x0B;							//25.x degC
+				payload[24 + (ntc_index * 2)] = static_cast<uint8_t>(0xA5 + pack->pack_index);
+			}
+			length = 31;
+			break;
+
+		case 0x04:
+			for(uint8_t cell_index = 0; cell_index < pack->cell_count; cell_index++)
+			{
+				payload[cell_index * 2]		= 0x0C;							//3.2xx V
+				payload[(cell_index * 2) + 1]	= static_cast<uint8_t>(0x80 + cell_index);
+			}
+			length = static_cast<uint8_t>(pack->cell_count * 2);
+			break;
+
+		case 0x05:
+			snprintf(reinterpret_cast<char*>(payload), sizeof(payload), "EMU-%02u", pack->pack_index);
+			length = 10;
+			break;
+
+		default:
+			return 0;
+	}
+
+	return buildFrame(response, request[2], payload, length);
+}
+
+
+
+/**
+  * @brief 	Pack Ready, info, cells and version of the emulated pack are in the snapshot
+  * @param[in]  BMS_SLAVE_UBT& slave, const emulated_pack_type& pack
+  * @return 	bool
+  */
+static bool packReady(BMS_SLAVE_UBT& slave, const emulated_pack_type& pack)
+{
+	bms_data_type data = slave.getData();
+	char version[11] = {0};
+
+	snprintf(version, sizeof(version), "EMU-%02u", pack.pack_index);
+
+	return (data.data.total_voltage_v > 0) &&
+	       (data.data.number_of_battery_strings == pack.cell_count) &&
+	       (data.data.cell_voltage_mv[pack.cell_count - 1] != 0) &&
+	       (memcmp(data.data.version_number, version, strlen(version)) == 0);
+}
+
+
+
+/**
+  * @brief 	Cache File Path of one port
+  * @param[in]  uint8_t port_index
+  * @param[out] char path[], size_t size
+  * @return 	void
+  */
+static void cachePath(uint8_t port_index, char path[], size_t size)
+{
+	snprintf(path, size, "bench_startup_port%u.cache", port_index);
+}
+
+
+
+/**
+  * @brief 	Startup Run, drivers on live_count live ports and every dead port, main loop until all live packs are ready
+  * @param[in]  uint8_t live_count
+  * @return 	startup_result_type
+  */
+static startup_result_type startupRun(uint8_t live_count)
+{
+	static char cache_paths[PORT_COUNT][64];
+	BMS_SLAVE_UBT* slaves[PORT_COUNT] = {nullptr};
+	uint32_t requests_before[PORT_COUNT] = {0};
+	startup_result_type result = {false, 0, 0, 0, 0};
+	std::chrono::steady_clock::time_point start;
+	uint8_t ready_count = 0;
+
+	for(uint8_t port_index = 0; port_index < PORT_COUNT; port_index++)
+	{
+		if((port_index >= live_count) && (port_index < LIVE_PACK_COUNT))
+		{
+			continue;
+		}
+
+		cachePath(port_index, cache_paths[port_index], sizeof(cache_paths[port_index]));
+		requests_before[port_index] = ports[port_index].getRequestCount();
+		slaves[port_index] = new BMS_SLAVE_UBT(ports[port_index]);
+		if(slaves[port_index]->initialize(cache_paths[port_index]) == true)
+		{
+			result.warm_count++;
+		}
+	}
+
+	start = std::chrono::steady_clock::now();
+	while(std::chrono::steady_clock::now() < (start + std::chrono::milliseconds(STARTUP_DEADLINE_MS)))
+	{
+		ready_count = 0;
+		for(uint8_t port_index = 0; port_index < PORT_COUNT; port_index++)
+		{
+			if(slaves[port_index] == nullptr)
+			{
+				continue;
+			}
+
+			slaves[port_index]->scheduler();
+			if((port_index < live_count) && (packReady(*slaves[port_index], emulated_packs[port_index]) == true))
+			{
+				ready_count++;
+			}
+		}
+
+		if(ready_count == live_count)
+		{
+			result.complete = true;
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(LOOP_PERIOD_US));
+	}
+	result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::this_thread::sleep_for(std::chrono::microseconds(PACK_LATENCY_US));				//let late answers land before the next run
+	for(uint8_t port_index = 0; port_index < PORT_COUNT; port_index++)
+	{
+		uint8_t stale_buffer[1024] = {0};
+
+		if(slaves[port_index] == nullptr)
+		{
+			continue;
+		}
+
+		if(port_index < LIVE_PACK_COUNT)
+		{
+			result.live_requests += ports[port_index].getRequestCount() - requests_before[port_index];
+		}
+		else
+		{
+			result.dead_requests += ports[port_index].getRequestCount() - requests_before[port_index];
+		}
+
+		ports[port_index].readFromBuffer(stale_buffer, sizeof(stale_buffer));
+		delete slaves[port_index];
+	}
+
+	return result;
+}
+
+
+
+/**
+  * @brief 	Print one run
+  * @param[in]  const char* name, const startup_result_type& result, uint8_t live_count
+  * @return 	void
+  */
+static void printRun(const char* name, const startup_result_type& result, uint8_t live_count)
+{
+	printf("%-14s: %u live + %u dead ports, %s in %.0f ms, %u live requests, %u dead requests, %u warm\n",
+	       name, live_count, DEAD_PACK_COUNT, (result.complete == true) ? "ready" : "NOT READY", result.elapsed_ms,
+	       result.live_requests, result.dead_requests, result.warm_count);
+}
+
+
+
+int main(void)
+{
+	startup_result_type single;
+	startup_result_type cold;
+	startup_result_type warm;
+	char path[64] = {0};
+
+	for(uint8_t port_index = 0; port_index < PORT_COUNT; port_index++)
+	{
+		emulated_packs[port_index].pack_index = port_index;
+		emulated_packs[port_index].cell_count = static_cast<uint8_t>(13 + (port_index % 4));
+		if(port_index < LIVE_PACK_COUNT)
+		{
+			ports[port_index].attachEmulator(packEmulator, &emulated_packs[port_index], PACK_LATENCY_US);
+		}
+
+		cachePath(port_index, path, sizeof(path));
+		remove(path);
+	}
+
+	single = startupRun(1);
+	for(uint8_t port_index = 0; port_index < PORT_COUNT; port_index++)
+	{
+		cachePath(port_index, path, sizeof(path));
+		remove(path);
+	}
+
+	cold = startupRun(LIVE_PACK_COUNT);
+	warm = startupRun(LIVE_PACK_COUNT);
+
+	printRun("cold, 1 pack", single, 1);
+	printRun("cold", cold, LIVE_PACK_COUNT);
+	printRun("warm", warm, LIVE_PACK_COUNT);
+
+	for(uint8_t port_index = 0; port_index < PORT_COUNT; port_index++)
+	{
+		cachePath(port_index, path, sizeof(path));
+		remove(path);
+	}
+
+	return ((single.complete == true) && (cold.complete == true) && (warm.complete == true) && (warm.warm_count == LIVE_PACK_COUNT)) ? 0 : 1;
+}
+
+/********************************* END OF FILE *********************************/
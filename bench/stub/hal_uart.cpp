@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file	: hal_uart.cpp
+  * @brief	: Host Stub of the Uart HAL for the Benchmarks
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#include "hal_uart.hpp"
+
+
+/**
+  * @brief	Port object the driver's default instance is bound to
+  */
+HAL_UART uart1;
+
+/********************************* END OF FILE *********************************/
@@ -0,0 +1,151 @@
+/**
+  ******************************************************************************
+  * @file	: hal_uart.hpp
+  * @brief	: Host Stub of the Uart HAL for the Benchmarks
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#ifndef HAL_UART_HPP
+#define HAL_UART_HPP
+
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+
+
+/**
+  * @brief 	Emulator Callback, builds the pack answer to one request, returns its size, 0 for no answer
+  */
+typedef uint16_t (*hal_uart_emulator_type)(void* context, const uint8_t* request, uint16_t request_size, uint8_t* response, uint16_t response_size);
+
+
+
+/**
+  * @brief 	Uart Stub, same read/write calls as the target HAL, bytes are handed over in memory
+  * @note	With an emulator attached every request is answered after the given latency, like a pack on the line
+  */
+class HAL_UART
+{
+	public:
+		HAL_UART():
+			rx_buffer{},
+			rx_size(0),
+			tx_buffer{},
+			tx_size(0),
+			emulator(nullptr),
+			emulator_context(nullptr),
+			latency_us(0),
+			answer_buffer{},
+			answer_size(0),
+			answer_ready(),
+			request_count(0)
+		{ }
+
+		void writeToBuffer(uint8_t* buffer, uint16_t size)
+		{
+			tx_size = (size < sizeof(tx_buffer)) ? size : sizeof(tx_buffer);
+			memcpy(tx_buffer, buffer, tx_size);
+			request_count++;
+
+			if(emulator != nullptr)
+			{
+				answer_size	= emulator(emulator_context, tx_buffer, tx_size, answer_buffer, sizeof(answer_buffer));
+				answer_ready	= std::chrono::steady_clock::now() + std::chrono::microseconds(latency_us);
+				tx_size		= 0;
+			}
+		}
+
+		uint16_t readFromBuffer(uint8_t* buffer, uint16_t size)
+		{
+			uint16_t count = 0;
+
+			if((answer_size > 0) && (std::chrono::steady_clock::now() >= answer_ready))
+			{
+				inject(answer_buffer, answer_size);
+				answer_size = 0;
+			}
+
+			count = (rx_size < size) ? rx_size : size;
+
+			memcpy(buffer, rx_buffer, count);
+			memmove(rx_buffer, &rx_buffer[count], rx_size - count);
+			rx_size -= count;
+
+			return count;
+		}
+
+		/* bench side */
+		void inject(const uint8_t* buffer, uint16_t size)
+		{
+			if(size > (sizeof(rx_buffer) - rx_size))
+			{
+				size = sizeof(rx_buffer) - rx_size;
+			}
+			memcpy(&rx_buffer[rx_size], buffer, size);
+			rx_size += size;
+		}
+
+		uint16_t takeRequest(uint8_t* buffer, uint16_t size)
+		{
+			uint16_t count = (tx_size < size) ? tx_size : size;
+
+			memcpy(buffer, tx_buffer, count);
+			tx_size = 0;
+
+			return count;
+		}
+
+		void attachEmulator(hal_uart_emulator_type callback, void* context, uint32_t answer_latency_us)
+		{
+			emulator		= callback;
+			emulator_context	= context;
+			latency_us		= answer_latency_us;
+		}
+
+		uint32_t getRequestCount(void) const
+		{
+			return request_count;
+		}
+
+	private:
+		uint8_t rx_buffer[4096];
+		uint16_t rx_size;
+		uint8_t tx_buffer[64];
+		uint16_t tx_size;
+
+		hal_uart_emulator_type emulator;
+		void* emulator_context;
+		uint32_t latency_us;
+		uint8_t answer_buffer[256];
+		uint16_t answer_size;
+		std::chrono::steady_clock::time_point answer_ready;
+		uint32_t request_count;
+};
+
+
+
+extern HAL_UART uart1;
+
+
+
+#endif /* HAL_UART_HPP */
+
+/********************************* END OF FILE *********************************/
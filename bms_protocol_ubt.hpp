@@ -0,0 +1,258 @@
+/**
+  ******************************************************************************
+  * @file	: bms_protocol_ubt.hpp
+  * @brief	: Protocol Traits for 0xDD/0x77 Family BMS
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#ifndef BMS_PROTOCOL_UBT_HPP
+#define BMS_PROTOCOL_UBT_HPP
+
+
+#include <stdint.h>
+#include <string.h>
+#include "bms_slave_ubt.hpp"
+
+
+namespace Battery
+{
+
+namespace Ubtbat
+{
+
+
+
+/*|Frame Structure|**********************************************************************************************
+
+Request
+---------------------------------------------------------------------------------------------------------------
+Start Bit	Status Bit	     Command Code 	 Length			Checksum	     Stop Bit
+---------------------------------------------------------------------------------------------------------------
+  0xDD          0xA5(read)          	0X03		  0x00		 	 2Bytes		       0x77
+
+                0X5A(write)         	0X04
+
+                                    	0X05
+*****************************************************************************************************************
+Response
+---------------------------------------------------------------------------------------------------------------
+Start Bit       Command Code	      Status Bit         Length	        Payload      Checksum        Stop Bit
+---------------------------------------------------------------------------------------------------------------
+  0xDD              0X03       	   0x00(correct)                                      2Bytes           0x77
+
+                    0X04            0X80(error)
+
+                    0X05
+*****************************************************************************************************************/
+
+
+
+/**
+  * @brief	Ubetter Protocol Traits
+  * @note	A traits struct supplies framing constants, checksum rule and field decoders of one BMS variant at
+  *		compile time. BMS_SLAVE<PROTOCOL> calls them statically, so nothing is dispatched at run time inside
+  *		the byte loop. A new variant adds its traits here and an explicit instantiation in bms_slave_ubt.cpp.
+  */
+struct UBETTER_PROTOCOL
+{
+	static constexpr uint8_t START_BIT		= 0XDD;
+	static constexpr uint8_t STOP_BIT		= 0X77;
+
+	static constexpr uint8_t STATUS_BIT_READ	= 0XA5;
+	static constexpr uint8_t STATUS_BIT_WRITE	= 0X5A;
+
+	static constexpr uint8_t STATUS_CORRECT		= 0X00;
+	static constexpr uint8_t STATUS_ERROR		= 0X80;
+
+	static constexpr uint8_t COMMAND_CODE_INFO	= 0x03;
+	static constexpr uint8_t COMMAND_CODE_CELL	= 0x04;
+	static constexpr uint8_t COMMAND_CODE_VERS	= 0X05;
+
+	static constexpr uint8_t REQUEST_LENGTH		= 0X00;
+
+
+	/**
+	  * @brief 	Checksum Update, running sum of status/command, length and payload bytes
+	  * @param[in]  uint16_t checksum, uint8_t byte
+	  * @return 	uint16_t
+	  */
+	static inline uint16_t checksumUpdate(uint16_t checksum, uint8_t byte)
+	{
+		return static_cast<uint16_t>(checksum + byte);
+	}
+
+
+	/**
+	  * @brief 	Checksum Final, two's complement of the running sum
+	  * @param[in]  uint16_t checksum
+	  * @return 	uint16_t
+	  */
+	static inline uint16_t checksumFinal(uint16_t checksum)
+	{
+		return static_cast<uint16_t>(( ~checksum ) + 1);						// ( (0xFFFF - calculate_checksum) + 1)
+	}
+
+
+	/**
+	  * @brief 	Decode Info, command 0x03 payload
+	  * @param[in]  const uint8_t payload[], uint8_t length
+	  * @param[out] bms_data_type& bms_data
+	  * @return 	void
+	  */
+	static inline void decodeInfo(const uint8_t payload[], uint8_t length, bms_data_type& bms_data)
+	{
+		commnd_info_data_type info_type;
+		raw_data_info_type raw_type;
+
+		memcpy(&info_type.buffer[0], payload, (length < sizeof(info_type.buffer)) ? length : sizeof(info_type.buffer));
+
+		raw_type.data.total_voltage		= static_cast<uint16_t>(info_type.data.total_voltage_lo) 		| (static_cast<uint16_t>(info_type.data.total_voltage_hi) 		<< 8);
+		raw_type.data.current			= static_cast<uint16_t>(info_type.data.current_lo) 			| (static_cast<uint16_t>(info_type.data.current_hi) 			<< 8);
+		raw_type.data.residual_capacity		= static_cast<uint16_t>(info_type.data.residual_capacity_lo)		| (static_cast<uint16_t>(info_type.data.residual_capacity_hi) 	<< 8);
+		raw_type.data.nominal_capacity		= static_cast<uint16_t>(info_type.data.nominal_capacity_lo) 		| (static_cast<uint16_t>(info_type.data.nominal_capacity_hi) 	<< 8);
+		raw_type.data.number_of_cycles		= static_cast<uint16_t>(info_type.data.number_of_cycles_lo) 		| (static_cast<uint16_t>(info_type.data.number_of_cycles_hi) 	<< 8);
+		raw_type.data.production_date		= static_cast<uint16_t>(info_type.data.production_date_lo)		| (static_cast<uint16_t>(info_type.data.production_date_hi) 	<< 8);
+		raw_type.data.balance_status_low	= static_cast<uint16_t>(info_type.data.balance_status_low_lo) 		| (static_cast<uint16_t>(info_type.data.balance_status_low_hi) 	<< 8);
+		raw_type.data.balance_status_high	= static_cast<uint16_t>(info_type.data.balance_status_high_lo) 		| (static_cast<uint16_t>(info_type.data.balance_status_high_hi) << 8);
+		raw_type.data.protection_status		= static_cast<uint16_t>(info_type.data.protection_status_lo) 		| (static_cast<uint16_t>(info_type.data.protection_status_hi) 	<< 8);
+		raw_type.data.software_version		= info_type.data.software_version;
+		raw_type.data.remaining_capacity	= info_type.data.remaining_capacity;
+		raw_type.data.fet_control_status	= info_type.data.fet_control_status;
+		raw_type.data.number_of_battery		= info_type.data.number_of_battery;
+		raw_type.data.number_of_ntc		= info_type.data.number_of_ntc;
+		raw_type.data.cell_temp_1st		= static_cast<uint16_t>(info_type.data.cell_temp_1st_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_1st_hi) 		<< 8);
+		raw_type.data.cell_temp_2nd		= static_cast<uint16_t>(info_type.data.cell_temp_2nd_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_2nd_hi) 		<< 8);
+		raw_type.data.cell_temp_3rd		= static_cast<uint16_t>(info_type.data.cell_temp_3rd_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_3rd_hi) 		<< 8);
+		raw_type.data.cell_temp_4th		= static_cast<uint16_t>(info_type.data.cell_temp_4th_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_4th_hi) 		<< 8);
+
+
+
+		bms_data.data.total_voltage_v 			= static_cast<float>(raw_type.data.total_voltage) * 0.01;
+		bms_data.data.current_a 			= static_cast<float>(static_cast<int16_t>(raw_type.data.current)) * 0.01;		//signed, 10mA
+		bms_data.data.residual_capacity_mah 		= raw_type.data.residual_capacity * 10;
+		bms_data.data.nominal_capacity_mah		= raw_type.data.nominal_capacity * 10;
+		bms_data.data.number_of_cycles			= raw_type.data.number_of_cycles;
+		bms_data.data.production_date.data.years	= ((raw_type.data.production_date >> 9) + 2000);
+		bms_data.data.production_date.data.months	= ((raw_type.data.production_date >> 5) & 0x0F);
+		bms_data.data.production_date.data.days		= (raw_type.data.production_date & 0x1F);
+
+		bms_data.data.balance_status_low		= raw_type.data.balance_status_low;
+		bms_data.data.balance_status_high		= raw_type.data.balance_status_high;
+		bms_data.data.protection_status.u16		= raw_type.data.protection_status;
+		bms_data.data.software_version.data.major	= (raw_type.data.software_version / 10);
+		bms_data.data.software_version.data.minor	= (raw_type.data.software_version % 10);
+		bms_data.data.remaining_capacity_per		= raw_type.data.remaining_capacity;
+		bms_data.data.fet_control_status.u8		= raw_type.data.fet_control_status;
+
+		bms_data.data.number_of_battery_strings		= raw_type.data.number_of_battery;
+		bms_data.data.number_of_ntc			= raw_type.data.number_of_ntc;
+		bms_data.data.cell_temp_1st			= ((static_cast<float>(raw_type.data.cell_temp_1st) - 2731) / 10);
+		bms_data.data.cell_temp_2nd			= ((static_cast<float>(raw_type.data.cell_temp_2nd) - 2731) / 10);
+		bms_data.data.cell_temp_3rd			= ((static_cast<float>(raw_type.data.cell_temp_3rd) - 2731) / 10);
+		bms_data.data.cell_temp_4th			= ((static_cast<float>(raw_type.data.cell_temp_4th) - 2731) / 10);
+	}
+
+
+	/**
+	  * @brief 	Decode Cell, command 0x04 payload, big endian millivolts
+	  * @param[in]  const uint8_t payload[], uint8_t length
+	  * @param[out] bms_data_type& bms_data
+	  * @return 	void
+	  */
+	static inline void decodeCell(const uint8_t payload[], uint8_t length, bms_data_type& bms_data)
+	{
+		uint8_t cell_count = length / 2;
+
+		if(cell_count > (sizeof(bms_data.data.cell_voltage_mv) / sizeof(bms_data.data.cell_voltage_mv[0])))
+		{
+			cell_count = (sizeof(bms_data.data.cell_voltage_mv) / sizeof(bms_data.data.cell_voltage_mv[0]));
+		}
+
+		for(uint8_t cell_index = 0; cell_index < cell_count; cell_index++)
+		{
+			bms_data.data.cell_voltage_mv[cell_index] = (static_cast<uint16_t>(payload[cell_index * 2]) << 8) | payload[(cell_index * 2) + 1];
+		}
+	}
+
+
+	/**
+	  * @brief 	Decode Version, command 0x05 payload, ascii string
+	  * @param[in]  const uint8_t payload[], uint8_t length
+	  * @param[out] bms_data_type& bms_data
+	  * @return 	void
+	  */
+	static inline void decodeVersion(const uint8_t payload[], uint8_t length, bms_data_type& bms_data)
+	{
+		memcpy(&bms_data.data.version_number[0], payload, (length < sizeof(bms_data.data.version_number)) ? length : sizeof(bms_data.data.version_number));
+	}
+};
+
+
+
+/**
+  * @brief	JBD Protocol Traits
+  * @note	Same framing, checksum, cell and version frames as Ubetter. The info frame carries
+  *		a variable number of NTCs after the NTC count and, on newer firmware, trailing fields that are ignored.
+  */
+struct JBD_PROTOCOL: public UBETTER_PROTOCOL
+{
+	/**
+	  * @brief 	Decode Info, command 0x03 payload
+	  * @param[in]  const uint8_t payload[], uint8_t length
+	  * @param[out] bms_data_type& bms_data
+	  * @return 	void
+	  */
+	static inline void decodeInfo(const uint8_t payload[], uint8_t length, bms_data_type& bms_data)
+	{
+		const uint8_t NTC_OFFSET = 23;
+		float* cell_temp[4] = { &bms_data.data.cell_temp_1st, &bms_data.data.cell_temp_2nd, &bms_data.data.cell_temp_3rd, &bms_data.data.cell_temp_4th };
+		uint8_t ntc_index = 0;
+		uint16_t raw_temp = 0;
+
+		if(length < NTC_OFFSET)
+		{
+			return;
+		}
+
+		UBETTER_PROTOCOL::decodeInfo(payload, NTC_OFFSET, bms_data);						//shared fixed part
+
+		for(ntc_index = 0; ntc_index < 4; ntc_index++)
+		{
+			if((ntc_index >= bms_data.data.number_of_ntc) || ((NTC_OFFSET + (ntc_index * 2) + 1) >= length))
+			{
+				*cell_temp[ntc_index] = 0;
+				continue;
+			}
+
+			raw_temp = (static_cast<uint16_t>(payload[NTC_OFFSET + (ntc_index * 2)]) << 8) | payload[NTC_OFFSET + (ntc_index * 2) + 1];
+			*cell_temp[ntc_index] = ((static_cast<float>(raw_temp) - 2731) / 10);
+		}
+	}
+};
+
+
+} /* namespace Ubtbat */
+
+} /* namespace Battery */
+
+
+
+#endif /* BMS_PROTOCOL_UBT_HPP */
+
+/********************************* END OF FILE *********************************/
@@ -0,0 +1,376 @@
+/**
+  ******************************************************************************
+  * @file	: bms_rack_ubt.cpp
+  * @brief	: Rack Level Aggregation for Ubetter BMS
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#include <bms_rack_ubt.hpp>
+
+
+namespace Battery
+{
+
+namespace Ubtbat
+{
+
+
+
+const uint8_t RACK_MAX_CELLS		= 17;
+const uint8_t RACK_MAX_NTC		= 4;
+const float   RACK_NO_TEMP		= -1000.0;
+
+
+
+/**
+  * @brief 	Default constructor
+  * @param[in]  void
+  * @return 	void
+  */
+BMS_RACK_UBT::BMS_RACK_UBT():
+	history{}
+{
+	for(uint16_t node_index = 0; node_index < (2 * BMS_RACK_MAX_PACKS); node_index++)
+	{
+		clear(tree[node_index]);
+	}
+}
+
+
+
+/**
+  * @brief 	Update, replaces one pack leaf and recombines its path to the root
+  * @param[in]  uint16_t pack_index
+  * @param[in]  const bms_data_type& data	: latest decoded snapshot of the pack
+  * @param[in]  rack_frame_type frame		: command group that refreshed the snapshot
+  * @param[in]  uint64_t arrival_us		: stop bit arrival of that frame, steady clock
+  * @return 	bool false if pack index is out of range
+  */
+bool BMS_RACK_UBT::update(uint16_t pack_index, const bms_data_type& data, rack_frame_type frame, uint64_t arrival_us)
+{
+	bms_rack_info_sample_type* info_sample = nullptr;
+	bms_rack_cell_sample_type* cell_sample = nullptr;
+
+	bms_rack_summary_type* leaf = nullptr;
+	const float* cell_temp[RACK_MAX_NTC] = { &data.data.cell_temp_1st, &data.data.cell_temp_2nd, &data.data.cell_temp_3rd, &data.data.cell_temp_4th };
+	uint8_t cell_count = static_cast<uint8_t>(data.data.number_of_battery_strings);
+	uint8_t ntc_count = static_cast<uint8_t>(data.data.number_of_ntc);
+	uint8_t index = 0;
+
+	if(pack_index >= BMS_RACK_MAX_PACKS)
+	{
+		return false;
+	}
+
+	if((cell_count == 0) || (cell_count > RACK_MAX_CELLS))
+	{
+		cell_count = RACK_MAX_CELLS;										//info not seen yet, skip empty cells below
+	}
+	if(ntc_count > RACK_MAX_NTC)
+	{
+		ntc_count = RACK_MAX_NTC;
+	}
+
+	leaf = &tree[BMS_RACK_MAX_PACKS + pack_index];
+	clear(*leaf);
+
+	for(index = 0; index < cell_count; index++)
+	{
+		if(data.data.cell_voltage_mv[index] == 0)
+		{
+			continue;
+		}
+		if(data.data.cell_voltage_mv[index] < leaf->min_cell_mv)
+		{
+			leaf->min_cell_mv	= data.data.cell_voltage_mv[index];
+			leaf->min_cell_pack	= pack_index;
+			leaf->min_cell_index	= index;
+		}
+		if((leaf->max_cell_pack == BMS_RACK_NO_PACK) || (data.data.cell_voltage_mv[index] > leaf->max_cell_mv))
+		{
+			leaf->max_cell_mv	= data.data.cell_voltage_mv[index];
+			leaf->max_cell_pack	= pack_index;
+			leaf->max_cell_index	= index;
+		}
+	}
+
+	for(index = 0; index < ntc_count; index++)
+	{
+		if(*cell_temp[index] > leaf->max_temp)
+		{
+			leaf->max_temp		= *cell_temp[index];
+			leaf->max_temp_pack	= pack_index;
+			leaf->max_temp_index	= index;
+		}
+	}
+
+	leaf->sum_current_a	= data.data.current_a;
+	leaf->sum_voltage_v	= data.data.total_voltage_v;
+	leaf->pack_count	= 1;
+
+	propagate(pack_index);
+
+	if(frame == rack_frame_type::INFO)
+	{
+		history[pack_index].info_head	= (history[pack_index].info_head + 1) % BMS_RACK_HISTORY_DEPTH;
+		info_sample			= &history[pack_index].info[history[pack_index].info_head];
+		info_sample->time_us		= arrival_us;
+		info_sample->current_a		= data.data.current_a;
+		info_sample->total_voltage_v	= data.data.total_voltage_v;
+		info_sample->max_temp		= leaf->max_temp;
+	}
+	else if((frame == rack_frame_type::CELL) && (leaf->min_cell_pack != BMS_RACK_NO_PACK))
+	{
+		history[pack_index].cell_head	= (history[pack_index].cell_head + 1) % BMS_RACK_HISTORY_DEPTH;
+		cell_sample			= &history[pack_index].cell[history[pack_index].cell_head];
+		cell_sample->time_us		= arrival_us;
+		cell_sample->min_cell_mv	= leaf->min_cell_mv;
+		cell_sample->min_cell_index	= leaf->min_cell_index;
+		cell_sample->max_cell_mv	= leaf->max_cell_mv;
+		cell_sample->max_cell_index	= leaf->max_cell_index;
+	}
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Remove, drops a pack from the aggregation, e.g. when its link is lost
+  * @param[in]  uint16_t pack_index
+  * @return 	bool false if pack index is out of range
+  */
+bool BMS_RACK_UBT::remove(uint16_t pack_index)
+{
+	if(pack_index >= BMS_RACK_MAX_PACKS)
+	{
+		return false;
+	}
+
+	clear(tree[BMS_RACK_MAX_PACKS + pack_index]);
+	propagate(pack_index);
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Rack Summary Getter Function, O(1)
+  * @param[in]  void
+  * @return 	bms_rack_summary_type pack_count = 0 if no pack reported yet
+  */
+bms_rack_summary_type BMS_RACK_UBT::getSummary(void)
+{
+	return tree[1];
+}
+
+
+
+/**
+  * @brief 	Distance of a sample to the target instant
+  * @param[in]  uint64_t time_us, uint64_t target_us
+  * @return 	uint64_t
+  */
+static uint64_t sampleDistance(uint64_t time_us, uint64_t target_us)
+{
+	return (time_us > target_us) ? (time_us - target_us) : (target_us - time_us);
+}
+
+
+
+/**
+  * @brief 	Snapshot, assembles rack figures from the per-pack samples closest to target_us
+  * @note	Works on the stamped history only and never waits for new frames, O(N * depth).
+  *		Packs without a sample inside the window are left out and reported by the pack counts.
+  * @param[in]  uint64_t target_us	: instant on the steady clock used by the drivers
+  * @param[in]  uint32_t tolerance_us	: largest accepted distance of a sample to target_us
+  * @param[out] bms_rack_snapshot_type& snapshot
+  * @return 	bool false if no pack had any sample inside the window
+  */
+bool BMS_RACK_UBT::snapshot(uint64_t target_us, uint32_t tolerance_us, bms_rack_snapshot_type& snapshot)
+{
+	const bms_rack_info_sample_type* info_best = nullptr;
+	const bms_rack_cell_sample_type* cell_best = nullptr;
+	uint64_t distance = 0;
+	uint64_t best_distance = 0;
+	uint16_t pack_index = 0;
+	uint8_t sample_index = 0;
+
+	snapshot.target_us	= target_us;
+	snapshot.tolerance_us	= tolerance_us;
+	snapshot.max_skew_us	= 0;
+	snapshot.info_pack_count = 0;
+	snapshot.cell_pack_count = 0;
+	snapshot.sum_current_a	= 0;
+	snapshot.sum_voltage_v	= 0;
+	snapshot.sum_power_w	= 0;
+	snapshot.max_temp	= RACK_NO_TEMP;
+	snapshot.max_temp_pack	= BMS_RACK_NO_PACK;
+	snapshot.min_cell_mv	= UINT16_MAX;
+	snapshot.min_cell_pack	= BMS_RACK_NO_PACK;
+	snapshot.min_cell_index	= 0;
+	snapshot.max_cell_mv	= 0;
+	snapshot.max_cell_pack	= BMS_RACK_NO_PACK;
+	snapshot.max_cell_index	= 0;
+
+	for(pack_index = 0; pack_index < BMS_RACK_MAX_PACKS; pack_index++)
+	{
+		info_best = nullptr;
+		cell_best = nullptr;
+
+		for(sample_index = 0; sample_index < BMS_RACK_HISTORY_DEPTH; sample_index++)
+		{
+			distance = sampleDistance(history[pack_index].info[sample_index].time_us, target_us);
+			if((history[pack_index].info[sample_index].time_us != 0) && (distance <= tolerance_us) && ((info_best == nullptr) || (distance < best_distance)))
+			{
+				info_best = &history[pack_index].info[sample_index];
+				best_distance = distance;
+			}
+		}
+
+		if(info_best != nullptr)
+		{
+			snapshot.info_pack_count++;
+			snapshot.sum_current_a	+= info_best->current_a;
+			snapshot.sum_voltage_v	+= info_best->total_voltage_v;
+			snapshot.sum_power_w	+= info_best->current_a * info_best->total_voltage_v;
+			snapshot.max_skew_us	 = (best_distance > snapshot.max_skew_us) ? static_cast<uint32_t>(best_distance) : snapshot.max_skew_us;
+			if(info_best->max_temp > snapshot.max_temp)
+			{
+				snapshot.max_temp	= info_best->max_temp;
+				snapshot.max_temp_pack	= pack_index;
+			}
+		}
+
+		for(sample_index = 0; sample_index < BMS_RACK_HISTORY_DEPTH; sample_index++)
+		{
+			distance = sampleDistance(history[pack_index].cell[sample_index].time_us, target_us);
+			if((history[pack_index].cell[sample_index].time_us != 0) && (distance <= tolerance_us) && ((cell_best == nullptr) || (distance < best_distance)))
+			{
+				cell_best = &history[pack_index].cell[sample_index];
+				best_distance = distance;
+			}
+		}
+
+		if(cell_best != nullptr)
+		{
+			snapshot.cell_pack_count++;
+			snapshot.max_skew_us = (best_distance > snapshot.max_skew_us) ? static_cast<uint32_t>(best_distance) : snapshot.max_skew_us;
+			if(cell_best->min_cell_mv < snapshot.min_cell_mv)
+			{
+				snapshot.min_cell_mv	= cell_best->min_cell_mv;
+				snapshot.min_cell_pack	= pack_index;
+				snapshot.min_cell_index	= cell_best->min_cell_index;
+			}
+			if(cell_best->max_cell_mv > snapshot.max_cell_mv)
+			{
+				snapshot.max_cell_mv	= cell_best->max_cell_mv;
+				snapshot.max_cell_pack	= pack_index;
+				snapshot.max_cell_index	= cell_best->max_cell_index;
+			}
+		}
+	}
+
+	return ((snapshot.info_pack_count + snapshot.cell_pack_count) > 0);
+}
+
+
+
+/**
+  * @brief 	Propagate, recombines the parents of one leaf up to the root
+  * @param[in]  uint16_t pack_index
+  * @return 	void
+  */
+void BMS_RACK_UBT::propagate(uint16_t pack_index)
+{
+	for(uint16_t node_index = (BMS_RACK_MAX_PACKS + pack_index) / 2; node_index > 0; node_index /= 2)
+	{
+		combine(tree[node_index], tree[2 * node_index], tree[(2 * node_index) + 1]);
+	}
+}
+
+
+
+/**
+  * @brief 	Clear, neutral element of combine
+  * @param[out] bms_rack_summary_type& node
+  * @return 	void
+  */
+void BMS_RACK_UBT::clear(bms_rack_summary_type& node)
+{
+	node.min_cell_mv	= UINT16_MAX;
+	node.min_cell_pack	= BMS_RACK_NO_PACK;
+	node.min_cell_index	= 0;
+	node.max_cell_mv	= 0;
+	node.max_cell_pack	= BMS_RACK_NO_PACK;
+	node.max_cell_index	= 0;
+	node.max_temp		= RACK_NO_TEMP;
+	node.max_temp_pack	= BMS_RACK_NO_PACK;
+	node.max_temp_index	= 0;
+	node.sum_current_a	= 0;
+	node.sum_voltage_v	= 0;
+	node.pack_count		= 0;
+}
+
+
+
+/**
+  * @brief 	Combine, extremes and sums of two neighbouring ranges, ties keep the lower pack
+  * @param[out] bms_rack_summary_type& node
+  * @param[in]  const bms_rack_summary_type& left, right
+  * @return 	void
+  */
+void BMS_RACK_UBT::combine(bms_rack_summary_type& node, const bms_rack_summary_type& left, const bms_rack_summary_type& right)
+{
+	const bms_rack_summary_type& min_cell	= (right.min_cell_mv < left.min_cell_mv) ? right : left;
+	const bms_rack_summary_type& max_cell	= ((right.max_cell_pack != BMS_RACK_NO_PACK) && ((left.max_cell_pack == BMS_RACK_NO_PACK) || (right.max_cell_mv > left.max_cell_mv))) ? right : left;
+	const bms_rack_summary_type& max_temp	= (right.max_temp > left.max_temp) ? right : left;
+
+	node.min_cell_mv	= min_cell.min_cell_mv;
+	node.min_cell_pack	= min_cell.min_cell_pack;
+	node.min_cell_index	= min_cell.min_cell_index;
+	node.max_cell_mv	= max_cell.max_cell_mv;
+	node.max_cell_pack	= max_cell.max_cell_pack;
+	node.max_cell_index	= max_cell.max_cell_index;
+	node.max_temp		= max_temp.max_temp;
+	node.max_temp_pack	= max_temp.max_temp_pack;
+	node.max_temp_index	= max_temp.max_temp_index;
+	node.sum_current_a	= left.sum_current_a + right.sum_current_a;
+	node.sum_voltage_v	= left.sum_voltage_v + right.sum_voltage_v;
+	node.pack_count		= left.pack_count + right.pack_count;
+}
+
+
+
+/**
+  * @brief 	Default destructor
+  * @param[in]  void
+  * @return 	void
+  */
+BMS_RACK_UBT::~BMS_RACK_UBT()
+{ }
+
+
+} /* namespace Ubtbat */
+
+} /* namespace Battery */
+
+
+/********************************* END OF FILE *********************************/
@@ -0,0 +1,178 @@
+/**
+  ******************************************************************************
+  * @file	: bms_rack_ubt.hpp
+  * @brief	: Rack Level Aggregation for Ubetter BMS
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#ifndef BMS_RACK_UBT_HPP
+#define BMS_RACK_UBT_HPP
+
+
+#include <stdint.h>
+#include "bms_slave_ubt.hpp"
+
+
+namespace Battery
+{
+
+namespace Ubtbat
+{
+
+
+
+const uint16_t BMS_RACK_MAX_PACKS	= 256;
+const uint16_t BMS_RACK_NO_PACK		= 0XFFFF;
+const uint8_t  BMS_RACK_HISTORY_DEPTH	= 8;
+
+
+
+/**
+  * @brief 	Rack Frame Enum, which command group refreshed the pack snapshot
+  */
+enum class rack_frame_type: uint8_t
+{
+	INFO	= 0,
+	CELL	= 1,
+	OTHER	= 2,
+};
+
+
+
+/**
+  * @brief 	Rack Summary Type, also used as segment tree node over a range of packs
+  */
+struct bms_rack_summary_type
+{
+	uint16_t min_cell_mv;
+	uint16_t min_cell_pack;
+	uint8_t  min_cell_index;
+	uint16_t max_cell_mv;
+	uint16_t max_cell_pack;
+	uint8_t  max_cell_index;
+	float    max_temp;
+	uint16_t max_temp_pack;
+	uint8_t  max_temp_index;
+	float    sum_current_a;
+	float    sum_voltage_v;
+	uint16_t pack_count;
+};
+
+
+
+/**
+  * @brief 	Rack Info Sample Type, values of one info frame
+  */
+struct bms_rack_info_sample_type
+{
+	uint64_t time_us;
+	float    current_a;
+	float    total_voltage_v;
+	float    max_temp;
+};
+
+
+
+/**
+  * @brief 	Rack Cell Sample Type, extremes of one cell frame
+  */
+struct bms_rack_cell_sample_type
+{
+	uint64_t time_us;
+	uint16_t min_cell_mv;
+	uint16_t max_cell_mv;
+	uint8_t  min_cell_index;
+	uint8_t  max_cell_index;
+};
+
+
+
+/**
+  * @brief 	Rack Pack History Type, ring of the latest stamped samples per command group
+  */
+struct bms_rack_history_type
+{
+	bms_rack_info_sample_type info[BMS_RACK_HISTORY_DEPTH];
+	bms_rack_cell_sample_type cell[BMS_RACK_HISTORY_DEPTH];
+	uint8_t info_head;
+	uint8_t cell_head;
+};
+
+
+
+/**
+  * @brief 	Rack Snapshot Type, rack figures assembled from samples closest to one target instant
+  */
+struct bms_rack_snapshot_type
+{
+	uint64_t target_us;
+	uint32_t tolerance_us;
+	uint32_t max_skew_us;										//worst sample distance to target
+	uint16_t info_pack_count;									//packs with an info sample in the window
+	uint16_t cell_pack_count;									//packs with a cell sample in the window
+	float    sum_current_a;
+	float    sum_voltage_v;
+	float    sum_power_w;
+	float    max_temp;
+	uint16_t max_temp_pack;
+	uint16_t min_cell_mv;
+	uint16_t min_cell_pack;
+	uint8_t  min_cell_index;
+	uint16_t max_cell_mv;
+	uint16_t max_cell_pack;
+	uint8_t  max_cell_index;
+};
+
+
+
+/**
+  * @brief	Rack Aggregation, rack wide extremes and sums updated in O(log N) per decoded frame
+  */
+class BMS_RACK_UBT
+{
+	public:
+		BMS_RACK_UBT();
+		virtual ~BMS_RACK_UBT();
+
+		bool update(uint16_t pack_index, const bms_data_type& data, rack_frame_type frame, uint64_t arrival_us);
+		bool remove(uint16_t pack_index);
+		bms_rack_summary_type getSummary(void);
+		bool snapshot(uint64_t target_us, uint32_t tolerance_us, bms_rack_snapshot_type& snapshot);
+
+	private:
+		BMS_RACK_UBT(const BMS_RACK_UBT& orig);
+
+		void propagate(uint16_t pack_index);
+		static void clear(bms_rack_summary_type& node);
+		static void combine(bms_rack_summary_type& node, const bms_rack_summary_type& left, const bms_rack_summary_type& right);
+
+		bms_rack_summary_type tree[2 * BMS_RACK_MAX_PACKS];						//leaves at [BMS_RACK_MAX_PACKS, 2 * BMS_RACK_MAX_PACKS)
+		bms_rack_history_type history[BMS_RACK_MAX_PACKS];
+};
+
+
+} /* namespace Ubtbat */
+
+} /* namespace Battery */
+
+
+
+#endif /* BMS_RACK_UBT_HPP */
+
+/********************************* END OF FILE *********************************/
@@ -0,0 +1,371 @@
+/**
+  ******************************************************************************
+  * @file	: bms_shm_ubt.cpp
+  * @brief	: Shared Memory Telemetry for Ubetter BMS
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#include <bms_shm_ubt.hpp>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+namespace Battery
+{
+
+namespace Ubtbat
+{
+
+
+
+const uint8_t SHM_READ_RETRY		= 64;									//give up if the writer keeps the slot busy
+
+
+
+/**
+  * @brief 	Default constructor
+  * @param[in]  void
+  * @return 	void
+  */
+BMS_SHM_WRITER::BMS_SHM_WRITER():
+	segment(nullptr),
+	file_descriptor(-1)
+{ }
+
+
+
+/**
+  * @brief 	Open, creates or resizes the segment and resets every pack slot
+  * @note	Slot sequences only grow, so readers still mapping the segment from a previous writer never
+  *		accept a copy taken across the reset
+  * @param[in]  const char* name	: posix shm name, e.g. "/bms_ubt"
+  * @param[in]  uint16_t pack_count	: number of published packs
+  * @return 	bool false on system error or too many packs
+  */
+bool BMS_SHM_WRITER::open(const char* name, uint16_t pack_count)
+{
+	void* address = MAP_FAILED;
+	uint32_t sequence = 0;
+
+	if((pack_count == 0) || (pack_count > BMS_SHM_MAX_PACKS))
+	{
+		return false;
+	}
+
+	close();
+
+	file_descriptor = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if(file_descriptor < 0)
+	{
+		return false;
+	}
+
+	if(ftruncate(file_descriptor, sizeof(bms_shm_segment_type)) != 0)
+	{
+		close();
+		return false;
+	}
+
+	address = mmap(nullptr, sizeof(bms_shm_segment_type), PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+	if(address == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	segment = static_cast<bms_shm_segment_type*>(address);
+
+	segment->header.magic.store(0, std::memory_order_relaxed);						//invalidate while resetting
+	segment->header.layout_version	= BMS_SHM_LAYOUT_VERSION;
+	segment->header.pack_count	= pack_count;
+	segment->header.generation.fetch_add(1, std::memory_order_relaxed);					//monotonic across writer restarts
+
+	for(uint16_t pack_index = 0; pack_index < BMS_SHM_MAX_PACKS; pack_index++)
+	{
+		sequence = segment->pack[pack_index].sequence.load(std::memory_order_relaxed) | 1;		//odd, readers of the old mapping retry
+		segment->pack[pack_index].sequence.store(sequence, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		segment->pack[pack_index].generation.store(0, std::memory_order_relaxed);
+		memset(&segment->pack[pack_index].stamp, 0, sizeof(segment->pack[pack_index].stamp));
+		memset(segment->pack[pack_index].data.buffer, 0, sizeof(segment->pack[pack_index].data.buffer));
+
+		segment->pack[pack_index].sequence.store(sequence + 1, std::memory_order_release);		//even and newer than any value seen before
+	}
+
+	segment->header.magic.store(BMS_SHM_MAGIC, std::memory_order_release);
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Close, unmaps the segment, the segment itself stays for the readers
+  * @param[in]  void
+  * @return 	void
+  */
+void BMS_SHM_WRITER::close(void)
+{
+	if(segment != nullptr)
+	{
+		munmap(segment, sizeof(bms_shm_segment_type));
+		segment = nullptr;
+	}
+
+	if(file_descriptor >= 0)
+	{
+		::close(file_descriptor);
+		file_descriptor = -1;
+	}
+}
+
+
+
+/**
+  * @brief 	Publish, seqlock protected write of one pack snapshot
+  * @param[in]  uint16_t pack_index
+  * @param[in]  const bms_data_type& data
+  * @param[in]  const bms_shm_stamp_type& stamp	: frame times taken by the driver
+  * @return 	bool false if not open or index out of range
+  */
+bool BMS_SHM_WRITER::publish(uint16_t pack_index, const bms_data_type& data, const bms_shm_stamp_type& stamp)
+{
+	bms_shm_pack_type* pack = nullptr;
+	uint32_t sequence = 0;
+
+	if((segment == nullptr) || (pack_index >= segment->header.pack_count))
+	{
+		return false;
+	}
+
+	pack = &segment->pack[pack_index];
+	sequence = pack->sequence.load(std::memory_order_relaxed);
+
+	pack->sequence.store(sequence + 1, std::memory_order_relaxed);						//odd, slot busy
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy(pack->data.buffer, data.buffer, sizeof(pack->data.buffer));
+	pack->stamp = stamp;
+	pack->generation.store(pack->generation.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);	//single writer
+
+	pack->sequence.store(sequence + 2, std::memory_order_release);						//even, slot stable
+	segment->header.generation.fetch_add(1, std::memory_order_release);
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Default destructor
+  * @param[in]  void
+  * @return 	void
+  */
+BMS_SHM_WRITER::~BMS_SHM_WRITER()
+{
+	close();
+}
+
+
+
+/**
+  * @brief 	Default constructor
+  * @param[in]  void
+  * @return 	void
+  */
+BMS_SHM_READER::BMS_SHM_READER():
+	segment(nullptr),
+	file_descriptor(-1)
+{ }
+
+
+
+/**
+  * @brief 	Open, maps an existing segment read only
+  * @param[in]  const char* name	: posix shm name used by the writer
+  * @return 	bool false if segment is missing or has a different layout
+  */
+bool BMS_SHM_READER::open(const char* name)
+{
+	struct stat segment_stat;
+	void* address = MAP_FAILED;
+
+	close();
+
+	file_descriptor = shm_open(name, O_RDONLY, 0);
+	if(file_descriptor < 0)
+	{
+		return false;
+	}
+
+	if((fstat(file_descriptor, &segment_stat) != 0) || (static_cast<size_t>(segment_stat.st_size) < sizeof(bms_shm_segment_type)))
+	{
+		close();
+		return false;
+	}
+
+	address = mmap(nullptr, sizeof(bms_shm_segment_type), PROT_READ, MAP_SHARED, file_descriptor, 0);
+	if(address == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	segment = static_cast<const bms_shm_segment_type*>(address);
+
+	if((segment->header.magic.load(std::memory_order_acquire) != BMS_SHM_MAGIC) || (segment->header.layout_version != BMS_SHM_LAYOUT_VERSION))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Close, unmaps the segment
+  * @param[in]  void
+  * @return 	void
+  */
+void BMS_SHM_READER::close(void)
+{
+	if(segment != nullptr)
+	{
+		munmap(const_cast<bms_shm_segment_type*>(segment), sizeof(bms_shm_segment_type));
+		segment = nullptr;
+	}
+
+	if(file_descriptor >= 0)
+	{
+		::close(file_descriptor);
+		file_descriptor = -1;
+	}
+}
+
+
+
+/**
+  * @brief 	Pack Count Getter Function
+  * @param[in]  void
+  * @return 	uint16_t 0 if not open
+  */
+uint16_t BMS_SHM_READER::getPackCount(void)
+{
+	return (segment == nullptr) ? 0 : segment->header.pack_count;
+}
+
+
+
+/**
+  * @brief 	Segment Generation, changes whenever any pack was published
+  * @param[in]  void
+  * @return 	uint32_t
+  */
+uint32_t BMS_SHM_READER::getGeneration(void)
+{
+	return (segment == nullptr) ? 0 : segment->header.generation.load(std::memory_order_acquire);
+}
+
+
+
+/**
+  * @brief 	Pack Generation, cheap change check before a full read, same value read() returns
+  * @param[in]  uint16_t pack_index
+  * @return 	uint32_t 0 if never published since the writer opened the segment
+  */
+uint32_t BMS_SHM_READER::getGeneration(uint16_t pack_index)
+{
+	if((segment == nullptr) || (pack_index >= segment->header.pack_count))
+	{
+		return 0;
+	}
+
+	return segment->pack[pack_index].generation.load(std::memory_order_acquire);
+}
+
+
+
+/**
+  * @brief 	Read, seqlock protected copy of one pack snapshot
+  * @param[in]  uint16_t pack_index
+  * @param[out] bms_shm_snapshot_type& snapshot
+  * @return 	bool false if not open, out of range or the writer kept the slot busy
+  */
+bool BMS_SHM_READER::read(uint16_t pack_index, bms_shm_snapshot_type& snapshot)
+{
+	const bms_shm_pack_type* pack = nullptr;
+	uint32_t sequence_begin = 0;
+	uint32_t sequence_end = 0;
+
+	if((segment == nullptr) || (pack_index >= segment->header.pack_count))
+	{
+		return false;
+	}
+
+	pack = &segment->pack[pack_index];
+
+	for(uint8_t retry = 0; retry < SHM_READ_RETRY; retry++)
+	{
+		sequence_begin = pack->sequence.load(std::memory_order_acquire);
+		if((sequence_begin & 1) != 0)
+		{
+			continue;											//writer inside the slot
+		}
+
+		memcpy(snapshot.data.buffer, pack->data.buffer, sizeof(snapshot.data.buffer));
+		snapshot.stamp		= pack->stamp;
+		snapshot.generation	= pack->generation.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		sequence_end = pack->sequence.load(std::memory_order_relaxed);
+
+		if(sequence_begin == sequence_end)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+/**
+  * @brief 	Default destructor
+  * @param[in]  void
+  * @return 	void
+  */
+BMS_SHM_READER::~BMS_SHM_READER()
+{
+	close();
+}
+
+
+} /* namespace Ubtbat */
+
+} /* namespace Battery */
+
+
+/********************************* END OF FILE *********************************/
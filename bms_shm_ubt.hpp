@@ -0,0 +1,180 @@
+/**
+  ******************************************************************************
+  * @file	: bms_shm_ubt.hpp
+  * @brief	: Shared Memory Telemetry for Ubetter BMS
+ *******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 Makerland A.S.,
+  * All Rights Reserved </center></h2>
+  *
+  * All  information  contained  herein is,  and  remains  the property of
+  * Makerland A.S.The intellectual and technical concepts contained herein
+  * are proprietary  to  Makerland A.S. and are protected  by trade secret
+  * or copyright law.  Dissemination of this  information or  reproduction
+  * of this material is strictly forbidden unless prior written permission
+  * is obtained from   Makerland A.S.  Access to the source code contained
+  * herein is  hereby forbidden  to  anyone  except current Makerland A.S.
+  * employees, managers or contractors  who have executed  Confidentiality
+  * and Non-disclosure agreements explicitly covering such access.
+  *
+ *******************************************************************************
+  */
+
+#ifndef BMS_SHM_UBT_HPP
+#define BMS_SHM_UBT_HPP
+
+
+#include <stdint.h>
+#include <atomic>
+#include "bms_slave_ubt.hpp"
+
+
+namespace Battery
+{
+
+namespace Ubtbat
+{
+
+
+
+/*|Segment Layout|***********************************************************************************************
+
+---------------------------------------------------------------------------------------------------------------
+Header		magic, layout version, pack count, segment generation
+Pack[0]		sequence, generation, time stamps, bms_data_type			one cache line aligned slot per pack
+...
+Pack[N-1]
+---------------------------------------------------------------------------------------------------------------
+
+Sequence is odd while the owner process writes a slot. Readers copy the slot and retry if the sequence was odd
+or changed during the copy, so readers never block the writer and never enter the kernel after open().
+Time stamps are the driver's stop bit times in microseconds on the steady clock, not the publish time.
+*****************************************************************************************************************/
+
+
+
+const uint32_t BMS_SHM_MAGIC		= 0X42555442;								//"BUTB"
+const uint16_t BMS_SHM_LAYOUT_VERSION	= 2;
+const uint16_t BMS_SHM_MAX_PACKS	= 256;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "seqlock needs lock free atomics in shared memory");
+
+
+
+/**
+  * @brief 	Shared Memory Header Type
+  */
+struct bms_shm_header_type
+{
+	std::atomic<uint32_t> magic;										//written last, valid once set
+	uint16_t layout_version;
+	uint16_t pack_count;
+	std::atomic<uint32_t> generation;									//incremented on every publish
+};
+
+
+
+/**
+  * @brief 	Shared Memory Time Stamp Type, steady clock microseconds, 0 until the frame was seen
+  */
+struct bms_shm_stamp_type
+{
+	uint64_t frame_arrival_us;										//frame that caused this publish
+	uint64_t info_time_us;											//last info frame, pack level fields
+	uint64_t cell_time_us;											//last cell frame, cell voltages
+};
+
+
+
+/**
+  * @brief 	Shared Memory Pack Slot Type
+  */
+struct alignas(64) bms_shm_pack_type
+{
+	std::atomic<uint32_t> sequence;
+	std::atomic<uint32_t> generation;									//publishes since the writer opened
+	bms_shm_stamp_type stamp;
+	bms_data_type data;
+};
+
+
+
+/**
+  * @brief 	Shared Memory Segment Type
+  */
+struct bms_shm_segment_type
+{
+	bms_shm_header_type header;
+	bms_shm_pack_type pack[BMS_SHM_MAX_PACKS];
+};
+
+
+
+/**
+  * @brief 	Shared Memory Snapshot Type, consistent copy of one pack slot
+  */
+struct bms_shm_snapshot_type
+{
+	uint32_t generation;
+	bms_shm_stamp_type stamp;
+	bms_data_type data;
+};
+
+
+
+/**
+  * @brief	Shared Memory Writer, owned by the process that drives the UARTs
+  */
+class BMS_SHM_WRITER
+{
+	public:
+		BMS_SHM_WRITER();
+		virtual ~BMS_SHM_WRITER();
+
+		bool open(const char* name, uint16_t pack_count);
+		void close(void);
+		bool publish(uint16_t pack_index, const bms_data_type& data, const bms_shm_stamp_type& stamp);
+
+	private:
+		BMS_SHM_WRITER(const BMS_SHM_WRITER& orig);
+
+		bms_shm_segment_type* segment;
+		int file_descriptor;
+};
+
+
+
+/**
+  * @brief	Shared Memory Reader, any number of local consumer processes
+  */
+class BMS_SHM_READER
+{
+	public:
+		BMS_SHM_READER();
+		virtual ~BMS_SHM_READER();
+
+		bool open(const char* name);
+		void close(void);
+		uint16_t getPackCount(void);
+		uint32_t getGeneration(void);
+		uint32_t getGeneration(uint16_t pack_index);
+		bool read(uint16_t pack_index, bms_shm_snapshot_type& snapshot);
+
+	private:
+		BMS_SHM_READER(const BMS_SHM_READER& orig);
+
+		const bms_shm_segment_type* segment;
+		int file_descriptor;
+};
+
+
+} /* namespace Ubtbat */
+
+} /* namespace Battery */
+
+
+
+#endif /* BMS_SHM_UBT_HPP */
+
+/********************************* END OF FILE *********************************/
@@ -25,13 +25,19 @@
   */
 
 #include <bms_slave_ubt.hpp>
+#include <bms_protocol_ubt.hpp>
+#include <bms_shm_ubt.hpp>
+#include <bms_rack_ubt.hpp>
 #include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
 
 
 /**
   * @brief	Class object
   */
-Battery::Ubtbat::BMS_SLAVE_UBT ubetter();
+Battery::Ubtbat::BMS_SLAVE_UBT ubetter;
 
 namespace Battery
 {
@@ -41,313 +47,1531 @@ namespace Ubtbat
 
 
 
-/*|Frame Structure|**********************************************************************************************
+const uint32_t INFO_PERIOD_MS		= 200;									//5 Hz
+const uint32_t CELL_PERIOD_MS		= 1000;									//1 Hz
+const uint32_t VERS_PERIOD_MS		= 0;									//once at startup
+const uint32_t ONCE_RETRY_MS		= 1000;									//retry of read-once commands without answer
 
-Request
----------------------------------------------------------------------------------------------------------------
-Start Bit	Status Bit	     Command Code 	 Length			Checksum	     Stop Bit
----------------------------------------------------------------------------------------------------------------
-  0xDD          0xA5(read)          	0X03		  0x00		 	 2Bytes		       0x77
+const uint32_t RESPONSE_TIMEOUT_MS	= 150;									//longest frame at 9600 baud is ~45ms
+const uint8_t  DEGRADED_TIMEOUTS	= 2;									//consecutive timeouts until degraded
+const uint8_t  LOST_TIMEOUTS		= 5;									//consecutive timeouts until lost
+const uint8_t  DEGRADED_CHECKSUMS	= 3;									//consecutive checksum failures until degraded
+const uint32_t BACKOFF_MIN_MS		= 500;									//first probe delay of a lost pack
+const uint32_t BACKOFF_MAX_MS		= 30000;								//probe delay doubles up to this limit
+const uint8_t  STARTUP_PROBE_COUNT	= 3;									//immediate re-probes before backoff starts
 
-                0X5A(write)         	0X04
+const uint32_t CACHE_MAGIC		= 0X43425455;								//"UTBC"
+const uint8_t  CACHE_LAYOUT_VERSION	= 1;
+const uint8_t  VERS_CHECK_PRIORITY	= 0;									//background version check, any caller request goes first
+const uint32_t VERS_CHECK_TIMEOUT_MS	= 5000;									//dropped if not sent by then, queued again with the next info frame
 
-                                    	0X05
-*****************************************************************************************************************
-Response
----------------------------------------------------------------------------------------------------------------
-Start Bit       Command Code	      Status Bit         Length	        Payload      Checksum        Stop Bit
----------------------------------------------------------------------------------------------------------------
-  0xDD              0X03       	   0x00(correct)                                      2Bytes           0x77
+const uint8_t  ACTIVITY_MAX		= 0XFF;
+const float    ACTIVITY_CURRENT_MIN_A	= 0.2;									//current deadband, below counts as idle
+const float    ACTIVITY_CURRENT_FULL_A	= 5.0;									//current for full poll rate
+const float    ACTIVITY_CELL_FULL_MVPS	= 20.0;									//cell slope for full poll rate, mV/s
+const uint16_t ACTIVITY_CELL_MIN_MV	= 2;									//change deadband over a window, above one 1 mV LSB
+const uint32_t ACTIVITY_CELL_WINDOW_MS	= 900;									//slope window, just under the 1 Hz cell period
+const float    ACTIVITY_TEMP_FULL_CPM	= 1.0;									//temperature slope for full poll rate, C/min
+const float    ACTIVITY_TEMP_MIN_C	= 0.15;									//change deadband over a window, above one 0.1C LSB
+const uint32_t ACTIVITY_TEMP_WINDOW_MS	= 30000;								//slope window, frame to frame jitter would dominate
 
-                    0X04            0X80(error)
+const uint32_t BALANCE_MAX_GAP_MS	= 10000;								//longer gaps between info frames are not accounted
 
-                    0X05
-*****************************************************************************************************************/
 
 
+/**
+  * @brief 	Monotonic millisecond tick
+  * @param[in]  void
+  * @return 	uint32_t tick_ms, wraps after ~49 days
+  */
+static uint32_t systemTickMs(void)
+{
+	return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+
+/**
+  * @brief 	Monotonic microsecond tick
+  * @param[in]  void
+  * @return 	uint64_t tick_us, same clock as the shared memory and rack timestamps
+  */
+static uint64_t systemTickUs(void)
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+
+/**
+  * @brief 	Wrap-safe tick compare
+  * @param[in]  uint32_t now_ms, uint32_t due_ms
+  * @return 	bool true if due_ms has been reached
+  */
+static bool tickReached(uint32_t now_ms, uint32_t due_ms)
+{
+	return (static_cast<int32_t>(now_ms - due_ms) >= 0);
+}
+
+
+
+/**
+  * @brief 	Default constructor, pack on uart1
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+BMS_SLAVE<PROTOCOL>::BMS_SLAVE():
+	BMS_SLAVE(uart1)
+{ }
+
+
+
+/**
+  * @brief 	Constructor, pack on its own port
+  * @param[in]  hal_uart_type& uart	: port of this pack, selects the pack's channel on a multiplexed line
+  * @return 	void
+  */
+template <typename PROTOCOL>
+BMS_SLAVE<PROTOCOL>::BMS_SLAVE(hal_uart_type& uart):
+	uart_port(&uart),
+	bms_state(bms_state_type::COMMAND_REQUEST),
+	active_command(PROTOCOL::COMMAND_CODE_INFO),
+	periodic_commands{ {PROTOCOL::COMMAND_CODE_INFO, true, INFO_PERIOD_MS, 0},
+			   {PROTOCOL::COMMAND_CODE_CELL, true, CELL_PERIOD_MS, 0},
+			   {PROTOCOL::COMMAND_CODE_VERS, true, VERS_PERIOD_MS, 0} },
+	demand_queue{},
+	parse_state(parse_state_type::START_BIT),
+	payload_index(0),
+	request_sent_ms(0),
+	link_health(link_health_type::PROBING),
+	consecutive_timeouts(0),
+	consecutive_checksum_errors(0),
+	backoff_ms(BACKOFF_MIN_MS),
+	next_probe_ms(0),
+	last_valid_frame_ms(0),
+	valid_frame_seen(false),
+	startup_probes(0),
+	cache_path(nullptr),
+	cache_valid(false),
+	version_check_pending(false),
+	startup_cache(),
+	adaptive{},
+	balance{},
+	telemetry_writer(nullptr),
+	telemetry_pack_index(0),
+	rack_aggregation(nullptr),
+	bus_arbiter(nullptr),
+	rack_pack_index(0),
+	sniffer_mode(false),
+	sniff_request_pending(false),
+	sniff_request_status(0),
+	sniff_request_command(0),
+	sniff_request_length(0),
+	sniff_checksum(0),
+	sniff_request_checksum(0),
+	sniff_request_us(0),
+	sniff_request_read(0),
+	read_count(0),
+	command_latency{},
+	frame_arrival_us(0),
+	frame_time_us{}
+{ }
+
+
+
+/**
+  * @brief 	Initialize function, runs only once
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::initialize(void)
+{
+	initialize(nullptr);
+}
+
+
+
+/**
+  * @brief 	Initialize function with startup cache, runs only once
+  * @note	Cold start probes the pack. Each instance talks on the port given to its constructor, so packs
+  *		on different ports are probed in parallel when scheduler() of every instance runs from the main
+  *		loop; packs behind one multiplexed line take turns through the bus arbiter. Warm start takes cell/NTC counts and version from the cache, skips the probe
+  *		and the startup version read and polls info and cells right away. The version is read once in the background after the
+  *		first info and cell frames, so a replaced pack with the same counts does not keep the old version.
+  * @param[in]  const char* cache_file_path	: per pack cache file, nullptr disables the cache
+  * @return 	bool true on warm start
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::initialize(const char* cache_file_path)
+{
+	uint32_t now_ms = systemTickMs();
+
+	cache_path		= cache_file_path;
+	cache_valid		= cacheLoad();
+	version_check_pending	= cache_valid;
+	startup_probes		= 0;
+	bms_state		= bms_state_type::COMMAND_REQUEST;
+
+	for(uint8_t index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
+	{
+		periodic_commands[index].enabled	= true;
+		periodic_commands[index].next_due_ms	= now_ms;
+	}
+
+	if(cache_valid == false)
+	{
+		link_health = link_health_type::PROBING;
+		return false;
+	}
+
+	bms_data.data.number_of_battery_strings	= startup_cache.data.number_of_battery_strings;
+	bms_data.data.number_of_ntc		= startup_cache.data.number_of_ntc;
+	memcpy(&bms_data.data.version_number[0], &startup_cache.data.version_number[0], sizeof(bms_data.data.version_number));
+
+	findPeriodicCommand(PROTOCOL::COMMAND_CODE_VERS)->enabled = false;					//known from cache, checked after the first info frame
+	frame_time_us[findPeriodicCommand(PROTOCOL::COMMAND_CODE_VERS) - periodic_commands] = 0;
+	link_health = link_health_type::HEALTHY;
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Cache Load
+  * @param[in]  void
+  * @return 	bool true if a consistent cache record was read
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::cacheLoad(void)
+{
+	FILE* cache_file = nullptr;
+	size_t read_size = 0;
+
+	if(cache_path == nullptr)
+	{
+		return false;
+	}
+
+	cache_file = fopen(cache_path, "rb");
+	if(cache_file == nullptr)
+	{
+		return false;
+	}
+
+	read_size = fread(startup_cache.buffer, 1, sizeof(startup_cache.buffer), cache_file);
+	fclose(cache_file);
+
+	return ((read_size == sizeof(startup_cache.buffer)) &&
+		(startup_cache.data.magic == CACHE_MAGIC) &&
+		(startup_cache.data.layout_version == CACHE_LAYOUT_VERSION) &&
+		(startup_cache.data.checksum == cacheChecksum()));
+}
+
+
+
+/**
+  * @brief 	Cache Update, runs with info and version frames, writes only when the pack map changed
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::cacheUpdate(void)
+{
+	bms_periodic_command_type* version = nullptr;
+
+	if((cache_path == nullptr) || (bms_data.data.number_of_battery_strings == 0))
+	{
+		return;												//info not decoded yet
+	}
+
+	version = findPeriodicCommand(PROTOCOL::COMMAND_CODE_VERS);
+
+	if((cache_valid == true) &&
+	   ((startup_cache.data.number_of_battery_strings != bms_data.data.number_of_battery_strings) ||
+	    (startup_cache.data.number_of_ntc != bms_data.data.number_of_ntc)))
+	{
+		cache_valid		= false;									//pack was replaced, read its version again
+		version_check_pending	= false;
+		version->enabled	= true;
+		version->next_due_ms	= systemTickMs();
+		frame_time_us[version - periodic_commands] = 0;
+	}
+
+	if(version_check_pending == true)
+	{
+		if(frame_time_us[version - periodic_commands] == 0)
+		{
+			if(getFrameTimeUs(PROTOCOL::COMMAND_CODE_CELL) != 0)						//cells first, they are not cached
+			{
+				requestCommand(PROTOCOL::COMMAND_CODE_VERS, VERS_CHECK_PRIORITY, VERS_CHECK_TIMEOUT_MS);	//merges with a queued check
+			}
+			return;
+		}
+		version_check_pending = false;
+	}
+
+	if((frame_time_us[version - periodic_commands] == 0) ||
+	   ((cache_valid == true) && (memcmp(&startup_cache.data.version_number[0], &bms_data.data.version_number[0], sizeof(startup_cache.data.version_number)) == 0)))
+	{
+		return;												//version pending or cache up to date
+	}
+
+	startup_cache.data.magic			= CACHE_MAGIC;
+	startup_cache.data.layout_version		= CACHE_LAYOUT_VERSION;
+	startup_cache.data.number_of_battery_strings	= static_cast<uint8_t>(bms_data.data.number_of_battery_strings);
+	startup_cache.data.number_of_ntc		= static_cast<uint8_t>(bms_data.data.number_of_ntc);
+	memcpy(&startup_cache.data.version_number[0], &bms_data.data.version_number[0], sizeof(startup_cache.data.version_number));
+	startup_cache.data.checksum			= cacheChecksum();
+
+	cacheSave();
+	cache_valid = true;
+}
+
+
+
+/**
+  * @brief 	Cache Save, write to a temporary file and rename so a reboot never leaves a torn record
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::cacheSave(void)
+{
+	char temp_path[256] = {0};
+	FILE* cache_file = nullptr;
+	bool result = false;
+
+	if(snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path) >= static_cast<int>(sizeof(temp_path)))
+	{
+		return;
+	}
+
+	cache_file = fopen(temp_path, "wb");
+	if(cache_file == nullptr)
+	{
+		return;
+	}
+
+	result = (fwrite(startup_cache.buffer, 1, sizeof(startup_cache.buffer), cache_file) == sizeof(startup_cache.buffer));
+	result = (fclose(cache_file) == 0) && result;
+
+	if(result == true)
+	{
+		rename(temp_path, cache_path);
+	}
+	else
+	{
+		remove(temp_path);
+	}
+}
+
+
+
+/**
+  * @brief 	Cache Checksum, protocol checksum over the record without the checksum field
+  * @param[in]  void
+  * @return 	uint16_t
+  */
+template <typename PROTOCOL>
+uint16_t BMS_SLAVE<PROTOCOL>::cacheChecksum(void)
+{
+	uint16_t checksum = 0;
+
+	for(uint8_t index = 0; index < (sizeof(startup_cache.buffer) - sizeof(startup_cache.data.checksum)); index++)
+	{
+		checksum = PROTOCOL::checksumUpdate(checksum, startup_cache.buffer[index]);
+	}
+
+	return PROTOCOL::checksumFinal(checksum);
+}
+
+
+
+/**
+  * @brief 	Request Send Function, runs with request
+  * @param[in]  uint8_t status_bit	:
+  * @param[in]  uint8_t command_code 	:
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::requestSend(uint8_t status_bit, uint8_t command_code)
+{
+	bms_ubetter_request_type bms_request_type;
+	uint8_t stale_buffer[1024] = {0};
+
+	uart_port->readFromBuffer(stale_buffer, sizeof(stale_buffer));							//drop late bytes of the previous exchange on the line
+
+	bms_request_type.data.start_bit			= PROTOCOL::START_BIT;
+	bms_request_type.data.status_bit	  	= status_bit;
+	bms_request_type.data.command_code 	 	= command_code;
+	bms_request_type.data.data_length	 	= PROTOCOL::REQUEST_LENGTH;
+	bms_request_type.data.stop_bit			= PROTOCOL::STOP_BIT;
+
+	calculateChecksum16(bms_request_type.buffer, sizeof(bms_request_type.buffer));						//crc calculate
+	uart_port->writeToBuffer(bms_request_type.buffer, sizeof(bms_request_type.buffer));						//request data buffer write
+}
+
+
+
+/**
+  * @brief 	Response Read function, runs with response
+  * @note	Parser state is kept in the instance, so a frame may span several reads. Link health is
+  *		updated for every finished frame, not only the last one of a read
+  * @param[in]  uint8_t command_code 	: expected command, any known command in sniffer mode
+  * @param[in]  uint32_t now_ms
+  * @return 	response_result_type last finished frame, PENDING until a complete or broken frame is seen
+  */
+template <typename PROTOCOL>
+response_result_type BMS_SLAVE<PROTOCOL>::responseRead(uint8_t command_code, uint32_t now_ms)
+{
+	uint8_t read_buffer[1024]	=	{0};
+	uint16_t read_buffer_size	=	0;
+	uint16_t read_index		=	0;
+	response_result_type result	=	response_result_type::PENDING;
+	response_result_type byte_result =	response_result_type::PENDING;
+	uint16_t payload_count		=	0;
+
+	read_buffer_size = uart_port->readFromBuffer(read_buffer, sizeof(read_buffer));
+	if(read_buffer_size > 0)
+	{
+		read_count++;											//read index for sniffer latency pairing
+	}
+
+	for(read_index = 0; read_index < read_buffer_size; read_index++)
+	{
+		if(parse_state == parse_state_type::PAYLOAD)
+		{
+			payload_count = bms_response.data.data_length - payload_index;				//payload in one copy, not byte by byte
+			if(payload_count > (read_buffer_size - read_index))
+			{
+				payload_count = read_buffer_size - read_index;
+			}
+
+			memcpy(&bms_response.data.payload[payload_index], &read_buffer[read_index], payload_count);
+			payload_index	+= payload_count;
+			read_index	+= payload_count - 1;
+
+			if(payload_index >= bms_response.data.data_length)
+			{
+				payload_index = 0;
+				parse_state = parse_state_type::CHECKSUM;
+			}
+			continue;
+		}
+
+		byte_result = parseByte(read_buffer[read_index], command_code);
+		if(byte_result != response_result_type::PENDING)
+		{
+			linkUpdate(byte_result, now_ms);
+			result = byte_result;
+		}
+	}
+
+	return result;
+}
+
+
+
+/**
+  * @brief 	Parse Byte, response state machine, also follows foreign requests in sniffer mode
+  * @param[in]  uint8_t byte		: received byte
+  * @param[in]  uint8_t command_code 	: expected response command
+  * @return 	response_result_type PENDING until a response frame is finished
+  */
+template <typename PROTOCOL>
+response_result_type BMS_SLAVE<PROTOCOL>::parseByte(uint8_t byte, uint8_t command_code)
+{
+	uint16_t calculated_checksum	=	0;
+	response_result_type result	=	response_result_type::PENDING;
+
+	switch(parse_state)
+	{
+		case parse_state_type::START_BIT:
+			if(byte == PROTOCOL::START_BIT)
+			{
+				bms_response.data.start_bit = byte;
+				parse_state = parse_state_type::COMMAND_CODE;
+			}
+			break;
+
+		case parse_state_type::COMMAND_CODE:
+			if((sniffer_mode == true) && ((byte == PROTOCOL::STATUS_BIT_READ) || (byte == PROTOCOL::STATUS_BIT_WRITE)))
+			{
+				sniff_request_status = byte;
+				parse_state = parse_state_type::REQUEST_COMMAND;					//foreign master request
+			}
+			else if((byte == command_code) || ((sniffer_mode == true) && (findPeriodicCommand(byte) != nullptr)))
+			{
+				bms_response.data.command_code = byte;
+				parse_state = parse_state_type::STATUS_BIT;
+			}
+			else
+			{
+				sniffPairing(false);										//answer to a command we do not decode
+				parse_state = parse_state_type::START_BIT;
+			}
+			break;
+
+		case parse_state_type::STATUS_BIT:
+			if(byte == PROTOCOL::STATUS_CORRECT)
+			{
+				bms_response.data.status_bit = byte;
+				parse_state = parse_state_type::LENGTH;
+			}
+			else if(byte == PROTOCOL::STATUS_ERROR)
+			{
+				bms_response.data.status_bit = byte;
+				result = response_result_type::STATUS_ERROR;
+				sniffPairing(false);
+				parse_state = parse_state_type::START_BIT;
+			}
+			else
+			{
+				parse_state = parse_state_type::START_BIT;
+			}
+			break;
+
+		case parse_state_type::LENGTH:
+			bms_response.data.data_length = byte;
+			payload_index = 0;
+			if(bms_response.data.data_length > sizeof(bms_response.data.payload))
+			{
+				parse_state = parse_state_type::START_BIT;
+			}
+			else
+			{
+				parse_state = (bms_response.data.data_length == 0) ? parse_state_type::CHECKSUM : parse_state_type::PAYLOAD;
+			}
+			break;
+
+		case parse_state_type::PAYLOAD:
+			bms_response.data.payload[payload_index++] = byte;						//Getting Message Values Into Array
+			if(payload_index >= bms_response.data.data_length)
+			{
+				payload_index = 0;
+				parse_state = parse_state_type::CHECKSUM;
+			}
+			break;
+
+		case parse_state_type::CHECKSUM:
+			if(payload_index == 0)
+			{
+				bms_response.data.checksum = static_cast<uint16_t>( byte ) << 8;
+				payload_index++;
+				break;
+			}
+
+			bms_response.data.checksum |= static_cast<uint16_t>( byte );
+			calculated_checksum = 0;
+
+			calculated_checksum = PROTOCOL::checksumUpdate(calculated_checksum, bms_response.data.status_bit);
+			calculated_checksum = PROTOCOL::checksumUpdate(calculated_checksum, bms_response.data.data_length);
+
+			for (uint8_t i = 0; i < bms_response.data.data_length; i++)
+			{
+				calculated_checksum = PROTOCOL::checksumUpdate(calculated_checksum, bms_response.data.payload[i]);
+			}
+
+			calculated_checksum = PROTOCOL::checksumFinal(calculated_checksum);
+
+			if(calculated_checksum == bms_response.data.checksum)
+			{
+				parse_state = parse_state_type::STOP_BIT;
+			}
+			else
+			{
+				result = response_result_type::CHECKSUM_ERROR;
+				sniffPairing(false);
+				parse_state = parse_state_type::START_BIT;
+			}
+			break;
+
+		case parse_state_type::STOP_BIT:
+			if(byte == PROTOCOL::STOP_BIT)
+			{
+				bms_response.data.stop_bit = byte;
+				frame_arrival_us = systemTickUs();							//stop bit seen, stamp before decoding
+				processData(bms_response);
+				result = response_result_type::VALID;
+				sniffPairing(true);
+			}
+			parse_state = parse_state_type::START_BIT;
+			break;
+
+		case parse_state_type::REQUEST_COMMAND:
+			sniff_request_command	= byte;
+			sniff_checksum		= PROTOCOL::checksumUpdate(0, byte);
+			parse_state		= parse_state_type::REQUEST_LENGTH;
+			break;
+
+		case parse_state_type::REQUEST_LENGTH:
+			sniff_request_length	= byte;
+			sniff_checksum		= PROTOCOL::checksumUpdate(sniff_checksum, byte);
+			payload_index		= 0;
+			parse_state		= (byte == 0) ? parse_state_type::REQUEST_CHECKSUM : parse_state_type::REQUEST_PAYLOAD;
+			break;
+
+		case parse_state_type::REQUEST_PAYLOAD:
+			sniff_checksum = PROTOCOL::checksumUpdate(sniff_checksum, byte);				//write payload is only checked, not kept
+			if(++payload_index >= sniff_request_length)
+			{
+				payload_index = 0;
+				parse_state = parse_state_type::REQUEST_CHECKSUM;
+			}
+			break;
+
+		case parse_state_type::REQUEST_CHECKSUM:
+			if(payload_index == 0)
+			{
+				sniff_request_checksum = static_cast<uint16_t>( byte ) << 8;
+				payload_index++;
+				break;
+			}
+
+			sniff_request_checksum |= static_cast<uint16_t>( byte );
+			sniff_checksum = PROTOCOL::checksumFinal(sniff_checksum);
+			parse_state = (sniff_checksum == sniff_request_checksum) ? parse_state_type::REQUEST_STOP : parse_state_type::START_BIT;
+			break;
+
+		case parse_state_type::REQUEST_STOP:
+			if((byte == PROTOCOL::STOP_BIT) && (sniff_request_status == PROTOCOL::STATUS_BIT_READ) && (findPeriodicCommand(sniff_request_command) != nullptr))
+			{
+				if(sniff_request_pending == true)
+				{
+					linkUpdate(response_result_type::PENDING, systemTickMs());			//previous read never answered, close it as a timeout
+				}
+				sniff_request_pending	= true;								//only reads the parser decodes are paired
+				sniff_request_us	= systemTickUs();
+				sniff_request_read	= read_count;
+			}
+			parse_state = parse_state_type::START_BIT;
+			break;
+
+		default:
+			parse_state = parse_state_type::START_BIT;
+			break;
+	}
+
+	return result;
+}
+
+
+
+/**
+  * @brief 	Calculate Checksum16 Uart
+  * @param[in]  data_buffer, size
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::calculateChecksum16(uint8_t  data_buffer[], uint8_t size)							//checksum message send
+{
+	uint16_t calculate_checksum = 0;
+	uint16_t checksum_index = 2;
+
+	for(checksum_index = 2; checksum_index < 4; checksum_index++)
+	{
+		calculate_checksum = PROTOCOL::checksumUpdate(calculate_checksum, data_buffer[checksum_index]);		//data sum process
+	}
+
+	calculate_checksum = PROTOCOL::checksumFinal(calculate_checksum);
+	data_buffer[size - 3] = (uint16_t) ((calculate_checksum & 0xFF00) >> 8);						//making chekcsum 2byte
+	data_buffer[size - 2] = (uint16_t) (calculate_checksum & 0xFF);								//making chekcsum 2byte
+}
+
+
+
+/**
+  * @brief 	Process Data
+  * @note	One clock read per frame: the stop bit stamp, the millisecond tick is derived from it
+  * @param[in]  const bms_ubetter_response_type& bms_response_type
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::processData(const bms_ubetter_response_type& bms_response_type)
+{
+	uint32_t now_ms = static_cast<uint32_t>(frame_arrival_us / 1000);					//same tick as systemTickMs()
+
+	switch(bms_response_type.data.command_code)
+	{
+		case PROTOCOL::COMMAND_CODE_INFO:
+			PROTOCOL::decodeInfo(bms_response_type.data.payload, bms_response_type.data.data_length, bms_data);
+			break;
+
+		case PROTOCOL::COMMAND_CODE_CELL:
+			PROTOCOL::decodeCell(bms_response_type.data.payload, bms_response_type.data.data_length, bms_data);
+			break;
+
+		case PROTOCOL::COMMAND_CODE_VERS:
+			PROTOCOL::decodeVersion(bms_response_type.data.payload, bms_response_type.data.data_length, bms_data);
+			break;
+
+		default:
+			break;
+	}
+
+	bms_periodic_command_type* periodic = findPeriodicCommand(bms_response_type.data.command_code);
+
+	if(periodic != nullptr)
+	{
+		frame_time_us[periodic - periodic_commands] = frame_arrival_us;
+	}
+
+	if((periodic != nullptr) && (periodic->period_ms == 0))
+	{
+		periodic->enabled = false;												//read-once command answered
+	}
+
+	if(bms_response_type.data.command_code == PROTOCOL::COMMAND_CODE_INFO)
+	{
+		balanceUpdate(now_ms);
+	}
+
+	adaptiveUpdate(bms_response_type.data.command_code, now_ms);
+
+	if(bms_response_type.data.command_code != PROTOCOL::COMMAND_CODE_CELL)
+	{
+		cacheUpdate();											//cells never change the cache record
+	}
+
+	if(telemetry_writer != nullptr)
+	{
+		bms_shm_stamp_type stamp = { frame_arrival_us, getFrameTimeUs(PROTOCOL::COMMAND_CODE_INFO), getFrameTimeUs(PROTOCOL::COMMAND_CODE_CELL) };
+
+		telemetry_writer->publish(telemetry_pack_index, bms_data, stamp);
+	}
+
+	if(rack_aggregation != nullptr)
+	{
+		rack_aggregation->update(rack_pack_index, bms_data,
+					 (bms_response_type.data.command_code == PROTOCOL::COMMAND_CODE_INFO) ? rack_frame_type::INFO :
+					 (bms_response_type.data.command_code == PROTOCOL::COMMAND_CODE_CELL) ? rack_frame_type::CELL : rack_frame_type::OTHER,
+					 frame_arrival_us);
+	}
+}
+
+
+
+/**
+  * @brief 	Activity Scale, maps value linearly between deadband and full scale
+  * @param[in]  float value, float min_value, float full_value
+  * @return 	uint8_t activity 0..ACTIVITY_MAX
+  */
+static uint8_t activityScale(float value, float min_value, float full_value)
+{
+	if(value <= min_value)
+	{
+		return 0;
+	}
+
+	if(value >= full_value)
+	{
+		return ACTIVITY_MAX;
+	}
+
+	return static_cast<uint8_t>(((value - min_value) / (full_value - min_value)) * ACTIVITY_MAX);
+}
+
+
+
+/**
+  * @brief 	Adaptive Update, rates pack activity from the latest decoded frame
+  * @param[in]  uint8_t command_code
+  * @param[in]  uint32_t now_ms
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::adaptiveUpdate(uint8_t command_code, uint32_t now_ms)
+{
+	uint8_t activity = 0;
+	uint8_t index = 0;
+	uint16_t delta_mv = 0;
+	uint16_t max_delta_mv = 0;
+	uint8_t cell_count = sizeof(adaptive.cell_ref_mv) / sizeof(adaptive.cell_ref_mv[0]);
+	float temp_max = bms_data.data.cell_temp_1st;
+	float delta_c = 0;
+
+	switch(command_code)
+	{
+		case PROTOCOL::COMMAND_CODE_INFO:
+			temp_max = fmaxf(fmaxf(temp_max, bms_data.data.cell_temp_2nd), fmaxf(bms_data.data.cell_temp_3rd, bms_data.data.cell_temp_4th));
+
+			if(adaptive.info_primed == true)
+			{
+				if(tickReached(now_ms, adaptive.temp_ref_ms + ACTIVITY_TEMP_WINDOW_MS) == true)
+				{
+					delta_c = fabsf(temp_max - adaptive.temp_ref_c);
+					adaptive.temp_slope_cpm	= (delta_c <= ACTIVITY_TEMP_MIN_C) ? 0 : (delta_c * 60000.0f / static_cast<float>(now_ms - adaptive.temp_ref_ms));
+					adaptive.temp_ref_c	= temp_max;
+					adaptive.temp_ref_ms	= now_ms;
+				}
+				activity = activityScale(adaptive.temp_slope_cpm, 0, ACTIVITY_TEMP_FULL_CPM);
+
+				if((bms_data.data.protection_status.u16 != adaptive.last_protection_status) ||
+				   (bms_data.data.fet_control_status.u8 != adaptive.last_fet_control_status))
+				{
+					activity = ACTIVITY_MAX;								//protection or fet change, snap back
+					for(index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
+					{
+						if((adaptive.enabled == true) && (periodic_commands[index].period_ms != 0))
+						{
+							periodic_commands[index].next_due_ms = now_ms;
+						}
+					}
+				}
+			}
+
+			if(activityScale(fabsf(bms_data.data.current_a), ACTIVITY_CURRENT_MIN_A, ACTIVITY_CURRENT_FULL_A) > activity)
+			{
+				activity = activityScale(fabsf(bms_data.data.current_a), ACTIVITY_CURRENT_MIN_A, ACTIVITY_CURRENT_FULL_A);
+			}
+
+			adaptive.last_protection_status		= bms_data.data.protection_status.u16;
+			adaptive.last_fet_control_status	= bms_data.data.fet_control_status.u8;
+			if(adaptive.info_primed == false)
+			{
+				adaptive.temp_ref_c		= temp_max;
+				adaptive.temp_ref_ms		= now_ms;
+				adaptive.temp_slope_cpm		= 0;
+			}
+			adaptive.info_primed			= true;
+			break;
+
+		case PROTOCOL::COMMAND_CODE_CELL:
+			if(adaptive.cell_primed == false)
+			{
+				memcpy(adaptive.cell_ref_mv, bms_data.data.cell_voltage_mv, sizeof(adaptive.cell_ref_mv));
+				adaptive.cell_ref_ms		= now_ms;
+				adaptive.cell_slope_mvps	= 0;
+				adaptive.cell_primed		= true;
+				break;
+			}
+
+			if(tickReached(now_ms, adaptive.cell_ref_ms + ACTIVITY_CELL_WINDOW_MS) == true)
+			{
+				for(index = 0; index < cell_count; index++)
+				{
+					delta_mv = (bms_data.data.cell_voltage_mv[index] > adaptive.cell_ref_mv[index]) ?
+						   (bms_data.data.cell_voltage_mv[index] - adaptive.cell_ref_mv[index]) :
+						   (adaptive.cell_ref_mv[index] - bms_data.data.cell_voltage_mv[index]);
+					max_delta_mv = (delta_mv > max_delta_mv) ? delta_mv : max_delta_mv;
+					adaptive.cell_ref_mv[index] = bms_data.data.cell_voltage_mv[index];
+				}
+				adaptive.cell_slope_mvps	= (max_delta_mv <= ACTIVITY_CELL_MIN_MV) ? 0 : (max_delta_mv * 1000.0f / static_cast<float>(now_ms - adaptive.cell_ref_ms));
+				adaptive.cell_ref_ms		= now_ms;
+			}
+			activity = activityScale(adaptive.cell_slope_mvps, 0, ACTIVITY_CELL_FULL_MVPS);
+			break;
+
+		default:
+			return;
+	}
+
+	adaptive.activity_level -= (adaptive.activity_level / 4);							//decay, one quiet frame is not idle
+	if(activity > adaptive.activity_level)
+	{
+		adaptive.activity_level = activity;
+	}
+}
+
+
+
+/**
+  * @brief 	Balance Update, accumulates per-cell balancing time from the balance bitmaps of an info frame
+  * @note	The interval since the previous info frame is credited to the cells balancing in that frame
+  * @param[in]  uint32_t now_ms
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::balanceUpdate(uint32_t now_ms)
+{
+	uint32_t mask = static_cast<uint32_t>(bms_data.data.balance_status_low) | (static_cast<uint32_t>(bms_data.data.balance_status_high) << 16);
+	uint32_t bits = 0;
+	uint32_t elapsed_ms = now_ms - balance.last_update_ms;
+	uint8_t cell_index = 0;
+
+	if((balance.primed == true) && (elapsed_ms <= BALANCE_MAX_GAP_MS))
+	{
+		balance.observed_ms += elapsed_ms;
+
+		for(bits = balance.active_mask; bits != 0; bits &= (bits - 1))						//visit set bits only
+		{
+			cell_index = static_cast<uint8_t>(__builtin_ctz(bits));
+			balance.on_time_ms[cell_index] += elapsed_ms;
+		}
+	}
+
+	for(bits = (mask & ~balance.active_mask); bits != 0; bits &= (bits - 1))					//balancing switched on
+	{
+		cell_index = static_cast<uint8_t>(__builtin_ctz(bits));
+		if(balance.activation_count[cell_index] < UINT16_MAX)
+		{
+			balance.activation_count[cell_index]++;
+		}
+	}
+
+	balance.active_mask	= mask;
+	balance.active_count	= static_cast<uint8_t>(__builtin_popcount(mask));
+	balance.last_update_ms	= now_ms;
+	balance.primed		= true;
+}
+
+
+
+/**
+  * @brief 	Balance Statistics Getter Function
+  * @param[in]  void
+  * @return 	bms_balance_stats_type
+  */
+template <typename PROTOCOL>
+bms_balance_stats_type BMS_SLAVE<PROTOCOL>::getBalanceStats(void)
+{
+	return balance;
+}
+
+
+
+/**
+  * @brief 	Balance Duty Cycle of one cell since the last reset
+  * @param[in]  uint8_t cell_index	: 0 based
+  * @return 	uint16_t duty 0..1000 permille
+  */
+template <typename PROTOCOL>
+uint16_t BMS_SLAVE<PROTOCOL>::getBalanceDutyPermille(uint8_t cell_index)
+{
+	if((cell_index >= BMS_BALANCE_CELL_COUNT) || (balance.observed_ms == 0))
+	{
+		return 0;
+	}
+
+	return static_cast<uint16_t>((balance.on_time_ms[cell_index] * 1000) / balance.observed_ms);
+}
+
+
+
+/**
+  * @brief 	Reset Balance Statistics, keeps the current bitmap as starting point
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::resetBalanceStats(void)
+{
+	balance.observed_ms = 0;
+	memset(balance.on_time_ms, 0, sizeof(balance.on_time_ms));
+	memset(balance.activation_count, 0, sizeof(balance.activation_count));
+}
+
+
+
+/**
+  * @brief 	Effective Period, stretches the base period towards the idle period of a quiet pack
+  * @param[in]  bms_periodic_command_type& periodic
+  * @return 	uint32_t period_ms
+  */
+template <typename PROTOCOL>
+uint32_t BMS_SLAVE<PROTOCOL>::effectivePeriod(const bms_periodic_command_type& periodic)
+{
+	if((adaptive.enabled == false) || (periodic.period_ms == 0) || (adaptive.idle_period_ms <= periodic.period_ms))
+	{
+		return periodic.period_ms;
+	}
+
+	return periodic.period_ms + static_cast<uint32_t>((static_cast<uint64_t>(adaptive.idle_period_ms - periodic.period_ms) * (ACTIVITY_MAX - adaptive.activity_level)) / ACTIVITY_MAX);
+}
+
+
+
+/**
+  * @brief 	Set Adaptive Polling
+  * @param[in]  bool enable			: scale poll periods with pack activity
+  * @param[in]  uint32_t idle_period_ms	: period of a fully idle pack, busy packs use the command period
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::setAdaptivePolling(bool enable, uint32_t idle_period_ms)
+{
+	adaptive.enabled	= enable;
+	adaptive.idle_period_ms	= idle_period_ms;
+	adaptive.activity_level	= ACTIVITY_MAX;										//start at full rate until data says otherwise
+}
+
+
+
+/**
+  * @brief 	Attach Telemetry, publishes every decoded frame into a shared memory slot
+  * @param[in]  BMS_SHM_WRITER* writer	: nullptr detaches
+  * @param[in]  uint16_t pack_index	: slot of this pack in the segment
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::attachTelemetry(BMS_SHM_WRITER* writer, uint16_t pack_index)
+{
+	telemetry_writer	= writer;
+	telemetry_pack_index	= pack_index;
+}
+
+
+
+/**
+  * @brief 	Attach Rack, feeds every decoded frame into a rack aggregation
+  * @param[in]  BMS_RACK_UBT* rack	: nullptr detaches
+  * @param[in]  uint16_t pack_index	: position of this pack in the rack
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::attachRack(BMS_RACK_UBT* rack, uint16_t pack_index)
+{
+	rack_aggregation	= rack;
+	rack_pack_index		= pack_index;
+}
+
+
+
+/**
+  * @brief 	Attach Bus, shares one multiplexed line with other packs through the arbiter, each on its own channel port
+  * @param[in]  BMS_BUS_ARBITER* arbiter	: nullptr for a dedicated line
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::attachBus(BMS_BUS_ARBITER* arbiter)
+{
+	if(bus_arbiter != nullptr)
+	{
+		bus_arbiter->release(this);
+	}
+
+	bus_arbiter = arbiter;
+}
+
+
+
+/**
+  * @brief 	Frame Time Getter Function, arrival of the last valid frame of one command group
+  * @param[in]  uint8_t command_code
+  * @return 	uint64_t steady clock us, 0 if never received
+  */
+template <typename PROTOCOL>
+uint64_t BMS_SLAVE<PROTOCOL>::getFrameTimeUs(uint8_t command_code)
+{
+	bms_periodic_command_type* periodic = findPeriodicCommand(command_code);
+
+	return (periodic == nullptr) ? 0 : frame_time_us[periodic - periodic_commands];
+}
+
+
+
+/**
+  * @brief 	Activity Level Getter Function
+  * @param[in]  void
+  * @return 	uint8_t 0 idle .. 255 full poll rate
+  */
+template <typename PROTOCOL>
+uint8_t BMS_SLAVE<PROTOCOL>::getActivityLevel(void)
+{
+	return adaptive.activity_level;
+}
+
+
+
+/**
+  * @brief 	Bms Getter Function
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+bms_data_type BMS_SLAVE<PROTOCOL>::getData(void)													
+{
+	return bms_data;
+}
+
+
+
+/**
+  * @brief 	Set Command Period
+  * @param[in]  uint8_t command_code	: info, cell or version command
+  * @param[in]  uint32_t period_ms	: 0 reads once, otherwise poll period
+  * @return 	bool false if command code is not polled
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::setCommandPeriod(uint8_t command_code, uint32_t period_ms)
+{
+	bms_periodic_command_type* periodic = findPeriodicCommand(command_code);
+
+	if(periodic == nullptr)
+	{
+		return false;
+	}
+
+	periodic->period_ms	= period_ms;
+	periodic->next_due_ms	= systemTickMs();
+	periodic->enabled	= true;
+
+	return true;
+}
+
+
+
+/**
+  * @brief 	Request Command, queues an on-demand read that preempts periodic polling
+  * @param[in]  uint8_t command_code	: info, cell or version command
+  * @param[in]  uint8_t priority	: higher value is served first
+  * @param[in]  uint32_t timeout_ms	: request is dropped if not sent within timeout
+  * @return 	bool false if command is unknown or queue is full
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::requestCommand(uint8_t command_code, uint8_t priority, uint32_t timeout_ms)
+{
+	uint32_t now_ms = systemTickMs();
+	uint8_t queue_index = 0;
+
+	if(findPeriodicCommand(command_code) == nullptr)
+	{
+		return false;
+	}
+
+	for(queue_index = 0; queue_index < BMS_DEMAND_QUEUE_SIZE; queue_index++)					//merge with same pending command
+	{
+		if((demand_queue[queue_index].used == true) && (demand_queue[queue_index].command_code == command_code))
+		{
+			if(priority > demand_queue[queue_index].priority)
+			{
+				demand_queue[queue_index].priority = priority;
+			}
+			if(tickReached(now_ms + timeout_ms, demand_queue[queue_index].deadline_ms))
+			{
+				demand_queue[queue_index].deadline_ms = now_ms + timeout_ms;
+			}
+			return true;
+		}
+	}
+
+	for(queue_index = 0; queue_index < BMS_DEMAND_QUEUE_SIZE; queue_index++)
+	{
+		if(demand_queue[queue_index].used == false)
+		{
+			demand_queue[queue_index].command_code	= command_code;
+			demand_queue[queue_index].priority	= priority;
+			demand_queue[queue_index].deadline_ms	= now_ms + timeout_ms;
+			demand_queue[queue_index].used		= true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+/**
+  * @brief 	Select Command, on-demand requests first, then the most overdue periodic command
+  * @param[in]  uint32_t now_ms
+  * @param[out] uint8_t& command_code
+  * @return 	bool false if nothing is due
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::selectCommand(uint32_t now_ms, uint8_t& command_code)
+{
+	bms_demand_command_type* demand = nullptr;
+	bms_periodic_command_type* periodic = nullptr;
+	uint32_t overdue_ms = 0;
+	uint8_t index = 0;
+
+	for(index = 0; index < BMS_DEMAND_QUEUE_SIZE; index++)
+	{
+		if(demand_queue[index].used == false)
+		{
+			continue;
+		}
+
+		if(tickReached(now_ms, demand_queue[index].deadline_ms + 1))						//deadline missed
+		{
+			demand_queue[index].used = false;
+			continue;
+		}
+
+		if((demand == nullptr) || (demand_queue[index].priority > demand->priority) ||
+		   ((demand_queue[index].priority == demand->priority) && tickReached(demand->deadline_ms, demand_queue[index].deadline_ms + 1)))
+		{
+			demand = &demand_queue[index];									//earliest deadline breaks ties
+		}
+	}
+
+	if(demand != nullptr)
+	{
+		command_code = demand->command_code;
+		demand->used = false;
+		return true;
+	}
 
-const uint8_t START_BIT			= 0XDD;
-const uint8_t STOP_BIT			= 0X77;
+	for(index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
+	{
+		if((periodic_commands[index].enabled == false) || (tickReached(now_ms, periodic_commands[index].next_due_ms) == false))
+		{
+			continue;
+		}
 
-const uint8_t STATUS_BIT_READ		= 0XA5;
-const uint8_t STATUS_BIT_WRITE		= 0X5A;
+		if((periodic == nullptr) || ((now_ms - periodic_commands[index].next_due_ms) > overdue_ms))
+		{
+			periodic = &periodic_commands[index];
+			overdue_ms = now_ms - periodic_commands[index].next_due_ms;
+		}
+	}
 
-const uint8_t STATUS_CORRECT		= 0X00;
-const uint8_t STATUS_ERROR		= 0X80;
+	if(periodic == nullptr)
+	{
+		return false;
+	}
 
-const uint8_t COMMAND_CODE_INFO		= 0x03;
-const uint8_t COMMAND_CODE_CELL		= 0x04;
-const uint8_t COMMAND_CODE_VERS		= 0X05;
+	command_code = periodic->command_code;
+	periodic->next_due_ms = now_ms + ((periodic->period_ms == 0) ? ONCE_RETRY_MS : effectivePeriod(*periodic));
 
-const uint8_t REQUEST_LENGTH		= 0X00;
+	return true;
+}
 
 
 
 /**
-  * @brief 	Default constructor
+  * @brief 	Find Periodic Command
+  * @param[in]  uint8_t command_code
+  * @return 	bms_periodic_command_type* nullptr if command is not polled
+  */
+template <typename PROTOCOL>
+bms_periodic_command_type* BMS_SLAVE<PROTOCOL>::findPeriodicCommand(uint8_t command_code)
+{
+	for(uint8_t index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
+	{
+		if(periodic_commands[index].command_code == command_code)
+		{
+			return &periodic_commands[index];
+		}
+	}
+
+	return nullptr;
+}
+
+
+
+/**
+  * @brief 	Link Health Getter Function
   * @param[in]  void
-  * @return 	void
+  * @return 	link_health_type
   */
-BMS_SLAVE_UBT::BMS_SLAVE_UBT()
-{ }
+template <typename PROTOCOL>
+link_health_type BMS_SLAVE<PROTOCOL>::getLinkHealth(void)
+{
+	return link_health;
+}
 
 
 
 /**
-  * @brief 	Initialize function, runs only once
+  * @brief 	Time Since Last Valid Frame
   * @param[in]  void
-  * @return 	void
+  * @return 	uint32_t elapsed ms, UINT32_MAX if no valid frame was received yet
   */
-void BMS_SLAVE_UBT::initialize(void)
+template <typename PROTOCOL>
+uint32_t BMS_SLAVE<PROTOCOL>::getTimeSinceValidFrameMs(void)
 {
+	if(valid_frame_seen == false)
+	{
+		return UINT32_MAX;
+	}
 
+	return systemTickMs() - last_valid_frame_ms;
 }
 
 
 
 /**
-  * @brief 	Request Send Function, runs with request
-  * @param[in]  uint8_t status_bit	:
-  * @param[in]  uint8_t command_code 	:
+  * @brief 	Discovery State, true once the pack answered or its map came from the startup cache
+  * @param[in]  void
+  * @return 	bool
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::isDiscovered(void)
+{
+	return (valid_frame_seen == true) || (cache_valid == true);
+}
+
+
+
+/**
+  * @brief 	Link Update, runs once per finished response frame or response timeout
+  * @param[in]  response_result_type result	: PENDING means the response timed out
+  * @param[in]  uint32_t now_ms
   * @return 	void
   */
-void BMS_SLAVE_UBT::requestSend(uint8_t status_bit, uint8_t command_code)
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::linkUpdate(response_result_type result, uint32_t now_ms)
 {
-	bms_ubetter_request_type bms_request_type;
+	switch(result)
+	{
+		case response_result_type::VALID:
+		case response_result_type::STATUS_ERROR:								//pack answered, link is alive
+			if(link_health == link_health_type::PROBING)
+			{
+				for(uint8_t index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
+				{
+					periodic_commands[index].next_due_ms = now_ms;					//fast re-admission
+				}
+			}
+			link_health			= link_health_type::HEALTHY;
+			consecutive_timeouts		= 0;
+			consecutive_checksum_errors	= 0;
+			backoff_ms			= BACKOFF_MIN_MS;
+			last_valid_frame_ms		= now_ms;
+			valid_frame_seen		= true;
+			break;
 
-	bms_request_type.data.start_bit			= START_BIT;
-	bms_request_type.data.status_bit	  	= status_bit;
-	bms_request_type.data.command_code 	 	= command_code;
-	bms_request_type.data.data_length	 	= REQUEST_LENGTH;
-	bms_request_type.data.stop_bit			= STOP_BIT;
+		case response_result_type::CHECKSUM_ERROR:
+			consecutive_timeouts = 0;
+			if(consecutive_checksum_errors < UINT8_MAX)
+			{
+				consecutive_checksum_errors++;
+			}
+			if(link_health == link_health_type::PROBING)
+			{
+				linkLost(now_ms);
+			}
+			else if(consecutive_checksum_errors >= DEGRADED_CHECKSUMS)
+			{
+				link_health = link_health_type::DEGRADED;
+			}
+			break;
 
-	calculateChecksum16(bms_request_type.buffer, sizeof(bms_request_type.buffer));						//crc calculate
-	uart1.writeToBuffer(bms_request_type.buffer, sizeof(bms_request_type.buffer));						//request data buffer write
+		case response_result_type::PENDING:
+			if(consecutive_timeouts < UINT8_MAX)
+			{
+				consecutive_timeouts++;
+			}
+			if((link_health == link_health_type::PROBING) || (consecutive_timeouts >= LOST_TIMEOUTS))
+			{
+				linkLost(now_ms);
+			}
+			else if(consecutive_timeouts >= DEGRADED_TIMEOUTS)
+			{
+				link_health = link_health_type::DEGRADED;
+			}
+			break;
+
+		default:
+			break;
+	}
 }
 
 
 
 /**
-  * @brief 	Response Read function, runs with response
-  * @param[in]  uint8_t command_code 	:
-  * @param[in]  uint8_t status_bit 	:
+  * @brief 	Link Lost, schedules the next probe with exponential backoff
+  * @param[in]  uint32_t now_ms
   * @return 	void
   */
-void BMS_SLAVE_UBT::responseRead(uint8_t command_code)
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::linkLost(uint32_t now_ms)
 {
-	static parse_state_type state = parse_state_type::START_BIT;
-	bms_ubetter_response_type bms_response_type;
+	if((valid_frame_seen == false) && (startup_probes < STARTUP_PROBE_COUNT))
+	{
+		startup_probes++;
+		link_health = link_health_type::PROBING;							//startup, probe again without backoff
+		return;
+	}
 
-	uint8_t read_buffer[1024]	=	{0};
-	uint16_t read_buffer_size	=	0;
-	static uint16_t read_index	=	0;
-	uint16_t calculated_checksum	=	0;
-	bool result			=	false;
+	if(link_health == link_health_type::PROBING)
+	{
+		backoff_ms = ((backoff_ms * 2) > BACKOFF_MAX_MS) ? BACKOFF_MAX_MS : (backoff_ms * 2);			//probe failed again
+	}
+	else
+	{
+		backoff_ms = BACKOFF_MIN_MS;
+	}
 
-	read_buffer_size = uart1.readFromBuffer(read_buffer, sizeof(read_buffer));
+	link_health	= link_health_type::LOST;
+	next_probe_ms	= now_ms + backoff_ms;
 
-	if(read_buffer_size > 0)
+	if(rack_aggregation != nullptr)
 	{
-		for(read_index = 0; read_index < read_buffer_size; read_index++)
-		{
-			switch(state)
-			{
-				case parse_state_type::START_BIT:
-					if(read_buffer[read_index] == START_BIT)
-					{
-						bms_response_type.data.start_bit = read_buffer[read_index];
-						state = parse_state_type::COMMAND_CODE;
-					}
-					break;
+		rack_aggregation->remove(rack_pack_index);							//stale data must not hold rack extremes
+	}
+}
 
-				case parse_state_type::COMMAND_CODE:
-					if(read_buffer[read_index] == command_code)
-					{
-						bms_response_type.data.command_code = read_buffer[read_index];
-						state = parse_state_type::STATUS_BIT;
-					}
-					else
-					{
-						state = parse_state_type::START_BIT;
-					}
-					break;
 
-				case parse_state_type::STATUS_BIT:
-					if(read_buffer[read_index] == STATUS_CORRECT)
-					{
-						bms_response_type.data.status_bit = read_buffer[read_index];
-						state = parse_state_type::LENGTH;
-					}
-					else if(read_buffer[read_index] == STATUS_ERROR)
-					{
-						bms_response_type.data.status_bit = read_buffer[read_index];
-						state = parse_state_type::START_BIT;
-					}
-					else
-					{
-						state = parse_state_type::START_BIT;
-					}
-					break;
 
-				case parse_state_type::LENGTH:
-					bms_response_type.data.data_length = read_buffer[read_index];
-					state = parse_state_type::PAYLOAD;
-					break;
+/**
+  * @brief 	Set Sniffer Mode, listen only, a foreign master polls the pack
+  * @param[in]  bool enable
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::setSnifferMode(bool enable)
+{
+	sniffer_mode		= enable;
+	sniff_request_pending	= false;
+	parse_state		= parse_state_type::START_BIT;
+	bms_state		= bms_state_type::COMMAND_REQUEST;
 
-				case parse_state_type::PAYLOAD:
-					bms_response_type.data.payload[read_index - 4] = read_buffer[read_index];							//Getting Message Values Into Array
-					if((read_index - 2) > bms_response_type.data.data_length)
-					{
-						state = parse_state_type::CHECKSUM;
-					}
-					break;
+	if(bus_arbiter != nullptr)
+	{
+		bus_arbiter->release(this);									//listen only, never owns the line
+	}
+}
 
-				case parse_state_type::CHECKSUM:
-					if((read_index - 4) > bms_response_type.data.data_length)
-					{
-						bms_response_type.data.checksum = static_cast<uint16_t>( read_buffer[read_index] ) | (static_cast<uint16_t>( read_buffer[read_index - 1] ) << 8);
 
-						for (uint8_t i = 0; i < bms_response_type.data.data_length; i++)
-						{
-							calculated_checksum += bms_response_type.data.payload[i];
-						}
 
-						calculated_checksum += bms_response_type.data.status_bit + bms_response_type.data.data_length;
-						calculated_checksum = (( ~calculated_checksum ) + 1);
+/**
+  * @brief 	Command Latency Getter Function, foreign master request to pack response
+  *		measured between scheduler() reads, the values depend on how often scheduler() is called
+  * @param[in]  uint8_t command_code
+  * @param[out] bms_latency_stats_type& stats
+  * @return 	bool false if command is not tracked
+  */
+template <typename PROTOCOL>
+bool BMS_SLAVE<PROTOCOL>::getCommandLatency(uint8_t command_code, bms_latency_stats_type& stats)
+{
+	for(uint8_t index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
+	{
+		if(periodic_commands[index].command_code == command_code)
+		{
+			stats = command_latency[index];
+			return true;
+		}
+	}
 
-						if(calculated_checksum == bms_response_type.data.checksum)
-						{
-							result = true;
-							state = parse_state_type::STOP_BIT;
-						}
-						else
-						{
-							state = parse_state_type::START_BIT;
-						}
-					}
-					break;
+	return false;
+}
 
-				case parse_state_type::STOP_BIT:
-					if(read_buffer[read_index] == STOP_BIT)
-					{
-						bms_response_type.data.stop_bit = read_buffer[read_index];
-						if(result == true)
-						{
-							processData(bms_response_type);
-						}
-					}
-					state = parse_state_type::START_BIT;
-					break;
 
-				default:
-					break;
-			}
-		}
+
+/**
+  * @brief 	Sniff Pairing, closes the pending foreign request on any response of the pack
+  * @param[in]  bool valid	: response decoded, latency is taken for the matching command only
+  * @return 	void
+  */
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::sniffPairing(bool valid)
+{
+	if((sniffer_mode == false) || (sniff_request_pending == false))
+	{
+		return;
+	}
+
+	if((valid == true) && (sniff_request_command == bms_response.data.command_code) && (sniff_request_read != read_count))
+	{												//same read has no usable time gap
+		latencyUpdate(sniff_request_command, static_cast<uint32_t>(frame_arrival_us - sniff_request_us));
 	}
+
+	sniff_request_pending = false;
 }
 
 
 
 /**
-  * @brief 	Calculate Checksum16 Uart
-  * @param[in]  data_buffer, size
+  * @brief 	Latency Update
+  * @param[in]  uint8_t command_code
+  * @param[in]  uint32_t latency_us
   * @return 	void
   */
-void BMS_SLAVE_UBT::calculateChecksum16(uint8_t  data_buffer[], uint8_t size)							//checksum message send
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::latencyUpdate(uint8_t command_code, uint32_t latency_us)
 {
-	uint16_t calculate_checksum = 0;
-	uint16_t checksum_index = 2;
-
-	for(checksum_index = 2; checksum_index < 4; checksum_index++)
+	for(uint8_t index = 0; index < BMS_PERIODIC_COMMAND_COUNT; index++)
 	{
-		calculate_checksum += data_buffer[checksum_index];								//data sum process
-	}
+		if(periodic_commands[index].command_code != command_code)
+		{
+			continue;
+		}
 
-	calculate_checksum = (( ~calculate_checksum ) + 1);									// ( (0xFFFF - calculate_checksum) + 1)
-	data_buffer[size - 3] = (uint16_t) ((calculate_checksum & 0xFF00) >> 8);						//making chekcsum 2byte
-	data_buffer[size - 2] = (uint16_t) (calculate_checksum & 0xFF);								//making chekcsum 2byte
+		if((command_latency[index].count == 0) || (latency_us < command_latency[index].min_us))
+		{
+			command_latency[index].min_us = latency_us;
+		}
+		if(latency_us > command_latency[index].max_us)
+		{
+			command_latency[index].max_us = latency_us;
+		}
+		command_latency[index].last_us	 = latency_us;
+		command_latency[index].total_us	+= latency_us;
+		command_latency[index].count++;
+		break;
+	}
 }
 
 
 
 /**
-  * @brief 	Process Data
-  * @param[in]  bms_ubetter_response_type bms_response_type
+  * @brief 	Scheduler function
+  * @param[in]  void
   * @return 	void
   */
-void BMS_SLAVE_UBT::processData(bms_ubetter_response_type bms_response_type)
+template <typename PROTOCOL>
+void BMS_SLAVE<PROTOCOL>::scheduler(void)
 {
-	static uint8_t cell_index = 0;
+	uint32_t now_ms = systemTickMs();
+	response_result_type result = response_result_type::PENDING;
 
-	switch(bms_response_type.data.command_code)
+	if(sniffer_mode == true)
 	{
+		result = responseRead(active_command, now_ms);								//never transmits
+		if((result == response_result_type::PENDING) && (sniff_request_pending == true) && ((systemTickUs() - sniff_request_us) > (RESPONSE_TIMEOUT_MS * 1000)))
+		{
+			sniff_request_pending = false;									//pack ignored the foreign master
+			linkUpdate(response_result_type::PENDING, now_ms);
+		}
+		return;
+	}
 
-		case COMMAND_CODE_INFO:
-
-			memcpy(&info_type.buffer[0], &bms_response_type.data.payload, bms_response_type.data.data_length);
-
-			raw_type.data.total_voltage		= static_cast<uint16_t>(info_type.data.total_voltage_lo) 		| (static_cast<uint16_t>(info_type.data.total_voltage_hi) 		<< 8);
-			raw_type.data.current			= static_cast<uint16_t>(info_type.data.current_lo) 			| (static_cast<uint16_t>(info_type.data.current_hi) 			<< 8);
-			raw_type.data.residual_capacity		= static_cast<uint16_t>(info_type.data.residual_capacity_lo)		| (static_cast<uint16_t>(info_type.data.residual_capacity_hi) 	<< 8);
-			raw_type.data.nominal_capacity		= static_cast<uint16_t>(info_type.data.nominal_capacity_lo) 		| (static_cast<uint16_t>(info_type.data.nominal_capacity_hi) 	<< 8);
-			raw_type.data.number_of_cycles		= static_cast<uint16_t>(info_type.data.number_of_cycles_lo) 		| (static_cast<uint16_t>(info_type.data.number_of_cycles_hi) 	<< 8);
-			raw_type.data.production_date		= static_cast<uint16_t>(info_type.data.production_date_lo)		| (static_cast<uint16_t>(info_type.data.production_date_hi) 	<< 8);
-			raw_type.data.balance_status_low	= static_cast<uint16_t>(info_type.data.balance_status_low_lo) 		| (static_cast<uint16_t>(info_type.data.balance_status_low_hi) 	<< 8);
-			raw_type.data.balance_status_high	= static_cast<uint16_t>(info_type.data.balance_status_high_lo) 		| (static_cast<uint16_t>(info_type.data.balance_status_high_hi) << 8);
-			raw_type.data.protection_status		= static_cast<uint16_t>(info_type.data.protection_status_lo) 		| (static_cast<uint16_t>(info_type.data.protection_status_hi) 	<< 8);
-			raw_type.data.software_version		= info_type.data.software_version;
-			raw_type.data.remaining_capacity	= info_type.data.remaining_capacity;
-			raw_type.data.fet_control_status	= info_type.data.fet_control_status;
-			raw_type.data.number_of_battery		= info_type.data.number_of_battery;
-			raw_type.data.number_of_ntc		= info_type.data.number_of_ntc;
-			raw_type.data.cell_temp_1st		= static_cast<uint16_t>(info_type.data.cell_temp_1st_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_1st_hi) 		<< 8);
-			raw_type.data.cell_temp_2nd		= static_cast<uint16_t>(info_type.data.cell_temp_2nd_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_2nd_hi) 		<< 8);
-			raw_type.data.cell_temp_3rd		= static_cast<uint16_t>(info_type.data.cell_temp_3rd_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_3rd_hi) 		<< 8);
-			raw_type.data.cell_temp_4th		= static_cast<uint16_t>(info_type.data.cell_temp_4th_lo) 		| (static_cast<uint16_t>(info_type.data.cell_temp_4th_hi) 		<< 8);
-
-
-
-			bms_data.data.total_voltage_v 			= static_cast<float>(raw_type.data.total_voltage) * 0.01;
-			bms_data.data.current_a 			= static_cast<float>(~(0xFFFF - raw_type.data.current)) * 0.01;
-			bms_data.data.residual_capacity_mah 		= raw_type.data.residual_capacity * 10;
-			bms_data.data.nominal_capacity_mah		= raw_type.data.nominal_capacity * 10;
-			bms_data.data.number_of_cycles			= raw_type.data.number_of_cycles;
-			bms_data.data.production_date.data.years	= ((raw_type.data.production_date >> 9) + 2000);
-			bms_data.data.production_date.data.months	= ((raw_type.data.production_date >> 5) & 0x0F);
-			bms_data.data.production_date.data.days		= (raw_type.data.production_date & 0x1F);
-
-			bms_data.data.balance_status_low		= raw_type.data.balance_status_low;
-			bms_data.data.balance_status_high		= raw_type.data.balance_status_high;
-			bms_data.data.protection_status.u16		= raw_type.data.protection_status;
-			bms_data.data.software_version.data.major	= (raw_type.data.software_version / 10);
-			bms_data.data.software_version.data.minor	= (raw_type.data.software_version % 10);
-			bms_data.data.remaining_capacity_per		= raw_type.data.remaining_capacity;
-			bms_data.data.fet_control_status.u8		= raw_type.data.fet_control_status;
-
-			bms_data.data.number_of_battery_strings		= raw_type.data.number_of_battery;
-			bms_data.data.number_of_ntc			= raw_type.data.number_of_ntc;
-			bms_data.data.cell_temp_1st			= ((static_cast<float>(raw_type.data.cell_temp_1st) - 2731) / 10);
-			bms_data.data.cell_temp_2nd			= ((static_cast<float>(raw_type.data.cell_temp_2nd) - 2731) / 10);
-			bms_data.data.cell_temp_3rd			= ((static_cast<float>(raw_type.data.cell_temp_3rd) - 2731) / 10);
-			bms_data.data.cell_temp_4th			= ((static_cast<float>(raw_type.data.cell_temp_4th) - 2731) / 10);
-
-			break;
+	switch(bms_state)
+	{
+		case bms_state_type::COMMAND_REQUEST:
+			if(link_health == link_health_type::LOST)
+			{
+				if(tickReached(now_ms, next_probe_ms) == false)
+				{
+					break;											//keep the bus free for live packs
+				}
+				link_health = link_health_type::PROBING;
+			}
 
-		case COMMAND_CODE_CELL:
-			memcpy(&cell_type.data.cell_voltage_mv[0], &bms_response_type.data.payload, bms_response_type.data.data_length);
+			if((bus_arbiter != nullptr) && (bus_arbiter->acquire(this) == false))
+			{
+				break;											//another pack owns the line
+			}
 
-			for(cell_index = 0; (cell_index < bms_response_type.data.data_length / 2); cell_index++)
+			if(link_health == link_health_type::PROBING)
+			{
+				active_command = PROTOCOL::COMMAND_CODE_INFO;								//single probe until the pack answers
+			}
+			else if(selectCommand(now_ms, active_command) == false)
 			{
-				cell_type.data.cell_voltage_mv[cell_index] = ((cell_type.data.cell_voltage_mv[cell_index] & 0xFF) << 8) | (cell_type.data.cell_voltage_mv[cell_index] >> 8);
+				if(bus_arbiter != nullptr)
+				{
+					bus_arbiter->release(this);
+				}
+				break;
 			}
 
-			memcpy(&bms_data.data.cell_voltage_mv[0], &cell_type.data.cell_voltage_mv[0], bms_response_type.data.data_length);
+			parse_state = parse_state_type::START_BIT;
+			requestSend(PROTOCOL::STATUS_BIT_READ, active_command);
+			request_sent_ms = now_ms;
+			bms_state = bms_state_type::COMMAND_RESPONSE;
 			break;
 
-		case COMMAND_CODE_VERS:
-			memcpy(&version_type.data.version_number[0], &bms_response_type.data.payload, bms_response_type.data.data_length);
-
-			memcpy(&bms_data.data.version_number[0], &version_type.data.version_number[0], bms_response_type.data.data_length);
+		case bms_state_type::COMMAND_RESPONSE:
+			result = responseRead(active_command, now_ms);
+			if((result != response_result_type::PENDING) || tickReached(now_ms, request_sent_ms + RESPONSE_TIMEOUT_MS))
+			{
+				if(result == response_result_type::PENDING)
+				{
+					linkUpdate(result, now_ms);								//timeout, finished frames were counted by the read
+				}
+				bms_state = bms_state_type::COMMAND_REQUEST;
+				if(bus_arbiter != nullptr)
+				{
+					bus_arbiter->release(this);
+				}
+			}
 			break;
 
 		default:
@@ -358,72 +1582,100 @@ void BMS_SLAVE_UBT::processData(bms_ubetter_response_type bms_response_type)
 
 
 /**
-  * @brief 	Bms Getter Function
+  * @brief 	Default copy constructor
+  * @param[in]  void
+  * @return 	void
+  */
+template <typename PROTOCOL>
+BMS_SLAVE<PROTOCOL>::BMS_SLAVE(const BMS_SLAVE& orig):
+	BMS_SLAVE(*orig.uart_port)
+{ }
+
+
+
+/**
+  * @brief 	Default destructor
   * @param[in]  void
   * @return 	void
   */
-bms_data_type BMS_SLAVE_UBT::getData(void)													
+template <typename PROTOCOL>
+BMS_SLAVE<PROTOCOL>::~BMS_SLAVE()
 {
-	return bms_data;
+	attachBus(nullptr);
 }
 
 
 
 /**
-  * @brief 	Scheduler function
+  * @brief 	Default constructor
   * @param[in]  void
   * @return 	void
   */
-void BMS_SLAVE_UBT::scheduler(void)
+BMS_BUS_ARBITER::BMS_BUS_ARBITER():
+	current_owner(nullptr),
+	last_owner(nullptr),
+	contended(false)
+{ }
+
+
+
+/**
+  * @brief 	Acquire, takes the line token for one request/response exchange
+  * @param[in]  const void* owner	: driver instance
+  * @return 	bool true if owner holds the token
+  */
+bool BMS_BUS_ARBITER::acquire(const void* owner)
 {
-	static bms_state_type state = bms_state_type::INFO_REQUEST;
+	if(current_owner == owner)
+	{
+		return true;
+	}
 
-	switch(state)
+	if(current_owner != nullptr)
 	{
-		case bms_state_type::INFO_REQUEST:
-			requestSend(STATUS_BIT_READ, COMMAND_CODE_INFO);
-			state = bms_state_type::INFO_RESPONSE;;
-			break;
+		contended = true;
+		return false;
+	}
 
-		case bms_state_type::INFO_RESPONSE:
-			responseRead(COMMAND_CODE_INFO);
-			state = bms_state_type::VERS_REQUEST;
-			break;
+	if((owner == last_owner) && (contended == true))
+	{
+		contended = false;											//yield one turn to the refused packs
+		return false;
+	}
 
-		case bms_state_type::VERS_REQUEST:
-			requestSend(STATUS_BIT_READ, COMMAND_CODE_VERS);
-			state = bms_state_type::VERS_RESPONSE;
-			break;
+	current_owner	= owner;
+	last_owner	= owner;
+	contended	= false;
 
-		case bms_state_type::VERS_RESPONSE:
-			responseRead(COMMAND_CODE_VERS);
-			state = bms_state_type::CELL_REQUEST;
-			break;
+	return true;
+}
 
-		case bms_state_type::CELL_REQUEST:
-			requestSend(STATUS_BIT_READ, COMMAND_CODE_CELL);
-			state = bms_state_type::CELL_RESPONSE;
-			break;
 
-		case bms_state_type::CELL_RESPONSE:
-			responseRead(COMMAND_CODE_CELL);
-			state = bms_state_type::INFO_REQUEST;
-			break;
 
-		default:
-			break;
+/**
+  * @brief 	Release, frees the line after the exchange finished or timed out
+  * @param[in]  const void* owner	: driver instance, ignored if it does not hold the token
+  * @return 	void
+  */
+void BMS_BUS_ARBITER::release(const void* owner)
+{
+	if(current_owner == owner)
+	{
+		current_owner = nullptr;
 	}
 }
 
 
 
 /**
-  * @brief 	Default copy constructor
+  * @brief 	Busy State
   * @param[in]  void
-  * @return 	void
+  * @return 	bool true while a request is outstanding on the line
   */
-BMS_SLAVE_UBT::BMS_SLAVE_UBT(const BMS_SLAVE_UBT& orig)
-{ }
+bool BMS_BUS_ARBITER::isBusy(void)
+{
+	return (current_owner != nullptr);
+}
 
 
 
@@ -432,10 +1684,17 @@ BMS_SLAVE_UBT::BMS_SLAVE_UBT(const BMS_SLAVE_UBT& orig)
   * @param[in]  void
   * @return 	void
   */
-BMS_SLAVE_UBT::~BMS_SLAVE_UBT()
+BMS_BUS_ARBITER::~BMS_BUS_ARBITER()
 { }
 
 
+/**
+  * @brief	Supported protocol variants
+  */
+template class BMS_SLAVE<UBETTER_PROTOCOL>;
+template class BMS_SLAVE<JBD_PROTOCOL>;
+
+
 } /* namespace Ubtbat */
 
 } /* namespace Battery */
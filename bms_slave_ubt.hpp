@@ -363,6 +363,31 @@ union bms_data_type
 
 
 
+/**
+  * @brief 	Startup Cache Type, per pack file written after discovery, read on warm start
+  */
+#pragma pack(1)
+union bms_startup_cache_type
+{
+	struct
+	{
+		uint32_t magic;
+		uint8_t  layout_version;
+		uint8_t  number_of_battery_strings;
+		uint8_t  number_of_ntc;
+		uint8_t  version_number[10];
+		uint16_t checksum;
+	}data;
+
+	uint8_t buffer[19];
+	bms_startup_cache_type():
+		buffer{}
+	{ }
+};
+#pragma pack()
+
+
+
 /**
   * @brief	 Parse State Enum
   */
@@ -375,6 +400,11 @@ enum class parse_state_type: uint8_t
 	PAYLOAD	 	 	= 4,
 	CHECKSUM		= 5,
 	STOP_BIT		= 6,
+	REQUEST_COMMAND		= 7,
+	REQUEST_LENGTH		= 8,
+	REQUEST_PAYLOAD		= 9,
+	REQUEST_CHECKSUM	= 10,
+	REQUEST_STOP		= 11,
 };
 
 
@@ -384,51 +414,293 @@ enum class parse_state_type: uint8_t
   */
 enum class bms_state_type: uint8_t
 {
-	INFO_REQUEST 	= 0,
-	INFO_RESPONSE 	= 1,
-	VERS_REQUEST	= 2,
-	VERS_RESPONSE	= 3,
-	CELL_REQUEST 	= 4,
-	CELL_RESPONSE	= 5,
+	COMMAND_REQUEST		= 0,
+	COMMAND_RESPONSE	= 1,
+};
+
+
+
+/**
+  * @brief 	Link Health Enum
+  */
+enum class link_health_type: uint8_t
+{
+	HEALTHY		= 0,
+	DEGRADED	= 1,
+	LOST		= 2,
+	PROBING		= 3,
+};
+
+
+
+/**
+  * @brief 	Response Result Enum
+  */
+enum class response_result_type: uint8_t
+{
+	PENDING		= 0,
+	VALID		= 1,
+	CHECKSUM_ERROR	= 2,
+	STATUS_ERROR	= 3,
+};
+
+
+
+/**
+  * @brief 	Adaptive Polling State
+  */
+struct bms_adaptive_state_type
+{
+	bool     enabled;
+	bool     info_primed;
+	bool     cell_primed;
+	uint8_t  activity_level;										//0 idle .. 255 busy
+	uint32_t idle_period_ms;
+	uint32_t temp_ref_ms;											//start of the running slope window
+	float    temp_ref_c;
+	float    temp_slope_cpm;									//slope of the last finished window
+	uint32_t cell_ref_ms;											//start of the running cell slope window
+	uint16_t cell_ref_mv[17];
+	float    cell_slope_mvps;									//largest cell slope of the last finished window
+	uint16_t last_protection_status;
+	uint8_t  last_fet_control_status;
+};
+
+
+
+/**
+  * @brief 	Command Latency Type, request stop bit to response stop bit
+  *		both ends are stamped when scheduler() reads the bytes, the resolution is the scheduler call period
+  *		pairs that arrive within the same read are not counted
+  */
+struct bms_latency_stats_type
+{
+	uint32_t count;
+	uint32_t last_us;
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+};
+
+
+
+/**
+  * @brief 	Cell Balancing Statistics, bit0 of balance_status_low is cell 1, balance_status_high holds cells 17-32
+  */
+const uint8_t BMS_BALANCE_CELL_COUNT		= 32;
+
+struct bms_balance_stats_type
+{
+	uint32_t active_mask;
+	uint8_t  active_count;
+	bool     primed;
+	uint32_t last_update_ms;
+	uint64_t observed_ms;											//64 bit, 32 bit ms wraps after 49.7 days
+	uint64_t on_time_ms[BMS_BALANCE_CELL_COUNT];
+	uint16_t activation_count[BMS_BALANCE_CELL_COUNT];
+};
+
+
+
+/**
+  * @brief	Command Queue Sizes
+  */
+const uint8_t BMS_PERIODIC_COMMAND_COUNT	= 3;
+const uint8_t BMS_DEMAND_QUEUE_SIZE		= 8;
+
+
+
+/**
+  * @brief 	Periodic Command Type, period_ms = 0 means read once until a valid frame arrives
+  */
+struct bms_periodic_command_type
+{
+	uint8_t  command_code;
+	bool     enabled;
+	uint32_t period_ms;
+	uint32_t next_due_ms;
 };
 
 
 
 /**
-  * @brief	Example Class Brief Info
+  * @brief 	On-Demand Command Type, higher priority value wins, dropped after deadline
   */
-class BMS_SLAVE_UBT
+struct bms_demand_command_type
+{
+	uint8_t  command_code;
+	uint8_t  priority;
+	bool     used;
+	uint32_t deadline_ms;
+};
+
+
+
+/**
+  * @brief	Bus Arbiter, one token per multiplexed line
+  * @note	For packs behind one line switch, where each driver's hal_uart_type port selects its own channel.
+  *		Requests carry no pack address, so packs on a plain multi-drop line cannot be told apart and are
+  *		not supported. Only the owner has a request outstanding. Lost packs that are backing off never ask for the token,
+  *		so their poll slots go to the live packs. An owner that releases while others were refused yields
+  *		its next turn, so a busy pack cannot starve its neighbours.
+  */
+class BMS_BUS_ARBITER
 {
 	public:
-		BMS_SLAVE_UBT();
+		BMS_BUS_ARBITER();
+		virtual ~BMS_BUS_ARBITER();
+
+		bool acquire(const void* owner);
+		void release(const void* owner);
+		bool isBusy(void);
+
+	private:
+		BMS_BUS_ARBITER(const BMS_BUS_ARBITER& orig);
+
+		const void* current_owner;
+		const void* last_owner;
+		bool contended;
+};
+
+
+
+class BMS_SHM_WRITER;
+class BMS_RACK_UBT;
+
+
+
+/**
+  * @brief	Uart HAL type, taken from the board port object so the driver does not name the HAL class
+  */
+typedef decltype(uart1) hal_uart_type;
+struct UBETTER_PROTOCOL;
+struct JBD_PROTOCOL;
+
+
+
+/**
+  * @brief	Generic 0xDD/0x77 family BMS driver, PROTOCOL traits live in bms_protocol_ubt.hpp
+  */
+template <typename PROTOCOL>
+class BMS_SLAVE
+{
+	public:
+		BMS_SLAVE();
+		explicit BMS_SLAVE(hal_uart_type& uart);
 
         void initialize(void);
+        bool initialize(const char* cache_file_path);
         void scheduler(void);
 
-        BMS_SLAVE_UBT(const BMS_SLAVE_UBT& orig);
-		virtual ~BMS_SLAVE_UBT();
+        BMS_SLAVE(const BMS_SLAVE& orig);
+		virtual ~BMS_SLAVE();
 		bms_data_type getData(void);
+
+		bool setCommandPeriod(uint8_t command_code, uint32_t period_ms);
+		bool requestCommand(uint8_t command_code, uint8_t priority, uint32_t timeout_ms);
+
+		link_health_type getLinkHealth(void);
+		uint32_t getTimeSinceValidFrameMs(void);
+		bool isDiscovered(void);
+
+		void setAdaptivePolling(bool enable, uint32_t idle_period_ms);
+		uint8_t getActivityLevel(void);
+		uint64_t getFrameTimeUs(uint8_t command_code);
+
+		bms_balance_stats_type getBalanceStats(void);
+		uint16_t getBalanceDutyPermille(uint8_t cell_index);
+		void resetBalanceStats(void);
+
+		void attachTelemetry(BMS_SHM_WRITER* writer, uint16_t pack_index);
+		void attachRack(BMS_RACK_UBT* rack, uint16_t pack_index);
+		void attachBus(BMS_BUS_ARBITER* arbiter);
+
+		void setSnifferMode(bool enable);
+		bool getCommandLatency(uint8_t command_code, bms_latency_stats_type& stats);
 	protected:
 
 	private:
+		bool selectCommand(uint32_t now_ms, uint8_t& command_code);
+		bms_periodic_command_type* findPeriodicCommand(uint8_t command_code);
+		uint32_t effectivePeriod(const bms_periodic_command_type& periodic);
+		void adaptiveUpdate(uint8_t command_code, uint32_t now_ms);
+		void balanceUpdate(uint32_t now_ms);
 		void requestSend(uint8_t status_bit, uint8_t command_code);
-		void responseRead(uint8_t command_code);
+		response_result_type responseRead(uint8_t command_code, uint32_t now_ms);
+		response_result_type parseByte(uint8_t byte, uint8_t command_code);
+		void latencyUpdate(uint8_t command_code, uint32_t latency_us);
+		void sniffPairing(bool valid);
+		void linkUpdate(response_result_type result, uint32_t now_ms);
+		void linkLost(uint32_t now_ms);
+		bool cacheLoad(void);
+		void cacheUpdate(void);
+		void cacheSave(void);
+		uint16_t cacheChecksum(void);
 		void calculateChecksum16(uint8_t  data_buffer[], uint8_t size);
-		void processData(bms_ubetter_response_type bms_response_type);
+		void processData(const bms_ubetter_response_type& bms_response_type);
 		void bitShift(uint8_t buffer[], uint8_t length);
 
+		hal_uart_type* uart_port;
 		bms_data_type bms_data;
 
-		//DEBUG------------------------------------------------------//
+		bms_state_type bms_state;
+		uint8_t active_command;
+		bms_periodic_command_type periodic_commands[BMS_PERIODIC_COMMAND_COUNT];
+		bms_demand_command_type demand_queue[BMS_DEMAND_QUEUE_SIZE];
+
+		parse_state_type parse_state;
+		bms_ubetter_response_type bms_response;
+		uint8_t payload_index;
+		uint32_t request_sent_ms;
+
+		link_health_type link_health;
+		uint8_t consecutive_timeouts;
+		uint8_t consecutive_checksum_errors;
+		uint32_t backoff_ms;
+		uint32_t next_probe_ms;
+		uint32_t last_valid_frame_ms;
+		bool valid_frame_seen;
+		uint8_t startup_probes;
+
+		const char* cache_path;
+		bool cache_valid;
+		bool version_check_pending;
+		bms_startup_cache_type startup_cache;
+
+		bms_adaptive_state_type adaptive;
+		bms_balance_stats_type balance;
+
+		BMS_SHM_WRITER* telemetry_writer;
+		uint16_t telemetry_pack_index;
+
+		BMS_RACK_UBT* rack_aggregation;
+		BMS_BUS_ARBITER* bus_arbiter;
+		uint16_t rack_pack_index;
+
+		bool sniffer_mode;
+		bool sniff_request_pending;
+		uint8_t sniff_request_status;
+		uint8_t sniff_request_command;
+		uint8_t sniff_request_length;
+		uint16_t sniff_checksum;
+		uint16_t sniff_request_checksum;
+		uint64_t sniff_request_us;
+		uint32_t sniff_request_read;
+		uint32_t read_count;
+		bms_latency_stats_type command_latency[BMS_PERIODIC_COMMAND_COUNT];
+
+		uint64_t frame_arrival_us;
+		uint64_t frame_time_us[BMS_PERIODIC_COMMAND_COUNT];
 
-		commnd_cell_data_type cell_type;
-		commnd_version_data_type version_type;
-		commnd_info_data_type info_type;
-		raw_data_info_type raw_type;
+};
 
-		//-----------------------------------------------------------//
 
-};
+
+/**
+  * @brief	Driver instances, explicitly instantiated in bms_slave_ubt.cpp
+  */
+typedef BMS_SLAVE<UBETTER_PROTOCOL> BMS_SLAVE_UBT;
+typedef BMS_SLAVE<JBD_PROTOCOL> BMS_SLAVE_JBD;
 
 
 } /* namespace Ubtbat */